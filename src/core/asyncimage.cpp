@@ -0,0 +1,69 @@
+#include "asyncimage.hpp"
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include <qbytearray.h>
+#include <qhash.h>
+#include <qimage.h>
+#include <qmutex.h>
+#include <qthreadpool.h>
+
+namespace {
+
+// Shared images are only tracked while alive. Expired entries are swept once the
+// table grows past this size.
+constexpr qsizetype SHARED_SWEEP_THRESHOLD = 64;
+
+QMutex sharedMutex;                                        // NOLINT
+QHash<QByteArray, std::weak_ptr<AsyncImage>> sharedImages; // NOLINT
+qsizetype sharedSweepSize = SHARED_SWEEP_THRESHOLD;        // NOLINT
+
+} // namespace
+
+std::shared_ptr<AsyncImage> AsyncImage::start(Decoder decoder) {
+	// constructor is private, so make_shared can't be used
+	auto image = std::shared_ptr<AsyncImage>(new AsyncImage());
+
+	QThreadPool::globalInstance()->start([image, decoder = std::move(decoder)]() {
+		image->decode(decoder);
+	});
+
+	return image;
+}
+
+std::shared_ptr<AsyncImage> AsyncImage::startShared(const QByteArray& key, Decoder decoder) {
+	auto locker = QMutexLocker(&sharedMutex);
+
+	if (auto image = sharedImages.value(key).lock()) {
+		return image;
+	}
+
+	if (sharedImages.size() >= sharedSweepSize) {
+		sharedImages.removeIf([](const auto& entry) { return entry.value().expired(); });
+		sharedSweepSize = std::max(sharedImages.size() * 2, SHARED_SWEEP_THRESHOLD);
+	}
+
+	auto image = AsyncImage::start(std::move(decoder));
+	sharedImages.insert(key, image);
+	return image;
+}
+
+void AsyncImage::decode(const Decoder& decoder) {
+	auto image = decoder();
+
+	auto locker = QMutexLocker(&this->mutex);
+	this->mImage = std::move(image);
+	this->finished = true;
+	this->condition.wakeAll();
+}
+
+QImage AsyncImage::image() {
+	auto locker = QMutexLocker(&this->mutex);
+
+	while (!this->finished) {
+		this->condition.wait(&this->mutex);
+	}
+
+	return this->mImage;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include <qbytearray.h>
+#include <qimage.h>
+#include <qmutex.h>
+#include <qtclasshelpermacros.h>
+#include <qwaitcondition.h>
+
+// Image decoded on the global thread pool as soon as it is created, so requests made
+// by QML later on only have to hand out the finished image.
+class AsyncImage {
+public:
+	using Decoder = std::function<QImage()>;
+
+	~AsyncImage() = default;
+	Q_DISABLE_COPY_MOVE(AsyncImage);
+
+	// Starts decoding an image.
+	static std::shared_ptr<AsyncImage> start(Decoder decoder);
+
+	// Starts decoding an image, or returns a live image previously started with
+	// identical key data. The key should contain everything decoding depends on.
+	static std::shared_ptr<AsyncImage> startShared(const QByteArray& key, Decoder decoder);
+
+	// Returns the decoded image, waiting for decoding to finish if it hasn't already.
+	[[nodiscard]] QImage image();
+
+private:
+	AsyncImage() = default;
+
+	void decode(const Decoder& decoder);
+
+	QMutex mutex;
+	QWaitCondition condition;
+	bool finished = false;
+	QImage mImage;
+};
@@ -1,15 +1,174 @@
 #include "clock.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <ctime>
 
 #include <qdatetime.h>
+#include <qlist.h>
+#include <qlogging.h>
+#include <qloggingcategory.h>
+#include <qnamespace.h>
 #include <qobject.h>
+#include <qsocketnotifier.h>
+#include <qtclasshelpermacros.h>
 #include <qtimer.h>
 #include <qtmetamacros.h>
+#include <qtypes.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
 #include "util.hpp"
 
-SystemClock::SystemClock(QObject* parent): QObject(parent) {
-	QObject::connect(&this->timer, &QTimer::timeout, this, &SystemClock::onTimeout);
-	this->update();
+Q_LOGGING_CATEGORY(logClock, "quickshell.clock", QtWarningMsg);
+
+// Wakes up at every boundary of one precision level and updates all clocks subscribed to it.
+//
+// Wakeups use a timerfd armed with an absolute wall clock time, so they never fire early
+// and are cancelled (waking up immediately) if the system time is changed.
+class SystemClockChannel {
+public:
+	explicit SystemClockChannel(SystemClock::Enum precision);
+	Q_DISABLE_COPY_MOVE(SystemClockChannel);
+
+	static SystemClockChannel* forPrecision(SystemClock::Enum precision);
+
+	void subscribe(SystemClock* clock);
+	void unsubscribe(SystemClock* clock);
+
+private:
+	void arm();
+	void disarm();
+	void onWakeup();
+	// seconds since the epoch of the next boundary
+	[[nodiscard]] qint64 nextBoundary() const;
+
+	SystemClock::Enum precision;
+	QVector<SystemClock*> clocks;
+	qint32 fd = -1;
+	QSocketNotifier notifier {QSocketNotifier::Read};
+	// used if a timerfd can't be created
+	QTimer fallbackTimer;
+};
+
+SystemClockChannel::SystemClockChannel(SystemClock::Enum precision): precision(precision) {
+	this->fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+
+	if (this->fd == -1) {
+		qCWarning(logClock) << "Could not create timerfd, falling back to a timer:"
+		                    << qt_error_string(errno);
+
+		this->fallbackTimer.setSingleShot(true);
+		this->fallbackTimer.setTimerType(Qt::PreciseTimer);
+
+		QObject::connect(&this->fallbackTimer, &QTimer::timeout, &this->fallbackTimer, [this]() {
+			this->onWakeup();
+		});
+	} else {
+		this->notifier.setSocket(this->fd);
+		this->notifier.setEnabled(false);
+
+		QObject::connect(&this->notifier, &QSocketNotifier::activated, &this->notifier, [this]() {
+			this->onWakeup();
+		});
+	}
+}
+
+SystemClockChannel* SystemClockChannel::forPrecision(SystemClock::Enum precision) {
+	static auto channels = std::array<SystemClockChannel*, 3>(); // NOLINT
+
+	auto& channel = channels.at(static_cast<size_t>(precision - SystemClock::Hours));
+	if (channel == nullptr) channel = new SystemClockChannel(precision);
+	return channel;
+}
+
+void SystemClockChannel::subscribe(SystemClock* clock) {
+	if (this->clocks.contains(clock)) return;
+	this->clocks.append(clock);
+	if (this->clocks.length() == 1) this->arm();
+}
+
+void SystemClockChannel::unsubscribe(SystemClock* clock) {
+	if (!this->clocks.removeOne(clock)) return;
+	if (this->clocks.isEmpty()) this->disarm();
+}
+
+qint64 SystemClockChannel::nextBoundary() const {
+	auto now = timespec();
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	switch (this->precision) {
+	case SystemClock::Seconds: return now.tv_sec + 1;
+	// every timezone in use is offset by whole minutes, so local and UTC minutes line up
+	case SystemClock::Minutes: return (now.tv_sec / 60 + 1) * 60;
+	default: {
+		// hours don't line up in timezones offset by a fraction of an hour
+		auto time = QDateTime::fromSecsSinceEpoch(now.tv_sec);
+		time.setTime(QTime(time.time().hour(), 0));
+		return time.addSecs(3600).toSecsSinceEpoch();
+	}
+	}
+}
+
+void SystemClockChannel::arm() {
+	auto next = this->nextBoundary();
+
+	if (this->fd == -1) {
+		auto delay = QDateTime::currentDateTime().msecsTo(QDateTime::fromSecsSinceEpoch(next));
+		this->fallbackTimer.start(static_cast<qint32>(std::max<qint64>(delay, 0)));
+		return;
+	}
+
+	auto spec = itimerspec {
+	    .it_interval = {},
+	    .it_value = {.tv_sec = next, .tv_nsec = 0},
+	};
+
+	auto flags = TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET;
+	if (timerfd_settime(this->fd, flags, &spec, nullptr) == -1) {
+		qCWarning(logClock) << "Could not arm clock timerfd:" << qt_error_string(errno);
+		return;
+	}
+
+	this->notifier.setEnabled(true);
+}
+
+void SystemClockChannel::disarm() {
+	if (this->fd == -1) {
+		this->fallbackTimer.stop();
+		return;
+	}
+
+	auto spec = itimerspec();
+	timerfd_settime(this->fd, 0, &spec, nullptr);
+	this->notifier.setEnabled(false);
+}
+
+void SystemClockChannel::onWakeup() {
+	if (this->fd != -1) {
+		quint64 expirations = 0;
+		auto result = read(this->fd, &expirations, sizeof(expirations));
+
+		// ECANCELED means the system time was changed, which needs an update all the same
+		if (result == -1 && errno == EAGAIN) return;
+	}
+
+	// read once and shared by every subscribed clock
+	auto time = QTime::currentTime();
+
+	// clocks may be unsubscribed by signal handlers
+	auto clocks = this->clocks;
+	for (auto* clock: clocks) {
+		if (this->clocks.contains(clock)) clock->setTime(time);
+	}
+
+	if (!this->clocks.isEmpty()) this->arm();
+}
+
+SystemClock::SystemClock(QObject* parent): QObject(parent) { this->update(); }
+
+SystemClock::~SystemClock() {
+	if (this->channel != nullptr) this->channel->unsubscribe(this);
 }
 
 bool SystemClock::enabled() const { return this->mEnabled; }
@@ -24,32 +183,33 @@ void SystemClock::setEnabled(bool enabled) {
 SystemClock::Enum SystemClock::precision() const { return this->mPrecision; }
 
 void SystemClock::setPrecision(SystemClock::Enum precision) {
+	if (precision < SystemClock::Hours || precision > SystemClock::Seconds) {
+		qCWarning(logClock) << "Invalid SystemClock precision" << static_cast<qint32>(precision)
+		                    << "- using the nearest valid precision.";
+
+		precision = std::clamp(precision, SystemClock::Hours, SystemClock::Seconds);
+	}
+
 	if (precision == this->mPrecision) return;
 	this->mPrecision = precision;
 	emit this->precisionChanged();
 	this->update();
 }
 
-void SystemClock::onTimeout() {
-	this->setTime(this->targetTime);
-	this->schedule(this->targetTime);
-}
-
 void SystemClock::update() {
+	if (this->channel != nullptr) {
+		this->channel->unsubscribe(this);
+		this->channel = nullptr;
+	}
+
 	if (this->mEnabled) {
-		this->setTime(QDateTime::fromMSecsSinceEpoch(0));
-		this->schedule(QDateTime::fromMSecsSinceEpoch(0));
-	} else {
-		this->timer.stop();
+		this->channel = SystemClockChannel::forPrecision(this->mPrecision);
+		this->channel->subscribe(this);
+		this->setTime(QTime::currentTime());
 	}
 }
 
-void SystemClock::setTime(const QDateTime& targetTime) {
-	auto currentTime = QDateTime::currentDateTime();
-	auto offset = currentTime.msecsTo(targetTime);
-	auto dtime = offset > -500 && offset < 500 ? targetTime : currentTime;
-	auto time = dtime.time();
-
+void SystemClock::setTime(const QTime& time) {
 	auto secondPrecision = this->mPrecision >= SystemClock::Seconds;
 	auto secondChanged = this->setSeconds(secondPrecision ? time.second() : 0);
 
@@ -62,35 +222,6 @@ void SystemClock::setTime(const QDateTime& targetTime) {
 	DropEmitter::call(secondChanged, minuteChanged, hourChanged);
 }
 
-void SystemClock::schedule(const QDateTime& targetTime) {
-	auto secondPrecision = this->mPrecision >= SystemClock::Seconds;
-	auto minutePrecision = this->mPrecision >= SystemClock::Minutes;
-	auto hourPrecision = this->mPrecision >= SystemClock::Hours;
-
-	auto currentTime = QDateTime::currentDateTime();
-
-	auto offset = currentTime.msecsTo(targetTime);
-
-	// timer skew
-	auto nextTime = offset > 0 && offset < 500 ? targetTime : currentTime;
-
-	auto baseTimeT = nextTime.time();
-	nextTime.setTime(
-	    {hourPrecision ? baseTimeT.hour() : 0,
-	     minutePrecision ? baseTimeT.minute() : 0,
-	     secondPrecision ? baseTimeT.second() : 0}
-	);
-
-	if (secondPrecision) nextTime = nextTime.addSecs(1);
-	else if (minutePrecision) nextTime = nextTime.addSecs(60);
-	else if (hourPrecision) nextTime = nextTime.addSecs(3600);
-
-	auto delay = currentTime.msecsTo(nextTime);
-
-	this->timer.start(static_cast<qint32>(delay));
-	this->targetTime = nextTime;
-}
-
 DEFINE_MEMBER_GETSET(SystemClock, hours, setHours);
 DEFINE_MEMBER_GETSET(SystemClock, minutes, setMinutes);
 DEFINE_MEMBER_GETSET(SystemClock, seconds, setSeconds);
@@ -3,12 +3,16 @@
 #include <qdatetime.h>
 #include <qobject.h>
 #include <qqmlintegration.h>
-#include <qtimer.h>
+#include <qtclasshelpermacros.h>
 #include <qtmetamacros.h>
 
 #include "util.hpp"
 
+class SystemClockChannel;
+
 ///! System clock accessor.
+/// All clocks with the same @@precision share a single wakeup at the start of each second,
+/// minute or hour, and update immediately if the system time is changed.
 class SystemClock: public QObject {
 	Q_OBJECT;
 	/// If the clock should update. Defaults to true.
@@ -35,6 +39,8 @@ public:
 	Q_ENUM(Enum);
 
 	explicit SystemClock(QObject* parent = nullptr);
+	~SystemClock() override;
+	Q_DISABLE_COPY_MOVE(SystemClock);
 
 	[[nodiscard]] bool enabled() const;
 	void setEnabled(bool enabled);
@@ -49,23 +55,20 @@ signals:
 	void minutesChanged();
 	void secondsChanged();
 
-private slots:
-	void onTimeout();
-
 private:
 	bool mEnabled = true;
 	SystemClock::Enum mPrecision = SystemClock::Seconds;
 	quint32 mHours = 0;
 	quint32 mMinutes = 0;
 	quint32 mSeconds = 0;
-	QTimer timer;
-	QDateTime targetTime;
+	SystemClockChannel* channel = nullptr;
 
 	void update();
-	void setTime(const QDateTime& targetTime);
-	void schedule(const QDateTime& targetTime);
+	void setTime(const QTime& time);
 
 	DECLARE_PRIVATE_MEMBER(SystemClock, hours, setHours, mHours, hoursChanged);
 	DECLARE_PRIVATE_MEMBER(SystemClock, minutes, setMinutes, mMinutes, minutesChanged);
 	DECLARE_PRIVATE_MEMBER(SystemClock, seconds, setSeconds, mSeconds, secondsChanged);
+
+	friend class SystemClockChannel;
 };
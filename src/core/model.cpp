@@ -1,9 +1,11 @@
 #include "model.hpp"
+#include <algorithm>
 
 #include <qabstractitemmodel.h>
 #include <qhash.h>
 #include <qobject.h>
 #include <qqmllist.h>
+#include <qtimer.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 #include <qvariant.h>
@@ -50,6 +52,29 @@ void UntypedObjectModel::insertObject(QObject* object, qsizetype index) {
 	emit this->objectInsertedPost(object, iindex);
 }
 
+void UntypedObjectModel::insertObjects(const QVector<QObject*>& objects, qsizetype index) {
+	if (objects.isEmpty()) return;
+
+	auto iindex = index == -1 ? this->valuesList.length() : index;
+
+	for (qsizetype i = 0; i != objects.length(); i++) {
+		emit this->objectInsertedPre(objects.at(i), iindex + i);
+	}
+
+	auto intIndex = static_cast<qint32>(iindex);
+	auto lastIndex = intIndex + static_cast<qint32>(objects.length()) - 1;
+	this->beginInsertRows(QModelIndex(), intIndex, lastIndex);
+	this->valuesList.insert(iindex, objects.length(), nullptr);
+	std::ranges::copy(objects, this->valuesList.begin() + iindex);
+	this->endInsertRows();
+
+	emit this->valuesChanged();
+
+	for (qsizetype i = 0; i != objects.length(); i++) {
+		emit this->objectInsertedPost(objects.at(i), iindex + i);
+	}
+}
+
 void UntypedObjectModel::removeAt(qsizetype index) {
 	auto* object = this->valuesList.at(index);
 	emit this->objectRemovedPre(object, index);
@@ -77,3 +102,52 @@ UntypedObjectModel* UntypedObjectModel::emptyInstance() {
 	static auto* instance = new UntypedObjectModel(nullptr); // NOLINT
 	return instance;
 }
+
+UntypedReadyBatcher::UntypedReadyBatcher(QObject* parent): QObject(parent) {
+	this->timer.setSingleShot(true);
+	this->timer.setInterval(BATCH_MSECS);
+	QObject::connect(&this->timer, &QTimer::timeout, this, &UntypedReadyBatcher::flush);
+}
+
+void UntypedReadyBatcher::addLoading(QObject* object) { this->loading.insert(object); }
+
+bool UntypedReadyBatcher::setReady(QObject* object) {
+	if (!this->loading.remove(object)) return false;
+
+	this->batch.append(object);
+
+	if (this->loading.isEmpty() && !this->held) {
+		this->flush();
+	} else if (!this->timer.isActive()) {
+		this->timer.start();
+	}
+
+	return true;
+}
+
+void UntypedReadyBatcher::remove(QObject* object) {
+	this->loading.remove(object);
+	this->batch.removeOne(object);
+}
+
+void UntypedReadyBatcher::clear() {
+	this->timer.stop();
+	this->loading.clear();
+	this->batch.clear();
+}
+
+void UntypedReadyBatcher::setHeld(bool held) {
+	this->held = held;
+	if (!held && this->loading.isEmpty()) this->flush();
+}
+
+bool UntypedReadyBatcher::isBatched(QObject* object) const { return this->batch.contains(object); }
+
+void UntypedReadyBatcher::flush() {
+	this->timer.stop();
+	if (this->batch.isEmpty()) return;
+
+	auto objects = this->batch;
+	this->batch.clear();
+	this->publish(objects);
+}
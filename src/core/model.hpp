@@ -1,10 +1,14 @@
 #pragma once
 
+#include <functional>
+
 #include <qabstractitemmodel.h>
 #include <qcontainerfwd.h>
 #include <qobject.h>
 #include <qqmlintegration.h>
 #include <qqmllist.h>
+#include <qset.h>
+#include <qtimer.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 #include <qvariant.h>
@@ -70,6 +74,8 @@ signals:
 
 protected:
 	void insertObject(QObject* object, qsizetype index = -1);
+	// Inserts all objects with a single model update. Insertion signals are still sent per object.
+	void insertObjects(const QVector<QObject*>& objects, qsizetype index = -1);
 	bool removeObject(const QObject* object);
 
 	QVector<QObject*> valuesList;
@@ -96,9 +102,74 @@ public:
 		this->UntypedObjectModel::insertObject(object, index);
 	}
 
+	void insertObjects(const QVector<T*>& objects, qsizetype index = -1) {
+		auto untyped = QVector<QObject*>();
+		untyped.reserve(objects.length());
+		for (auto* object: objects) untyped.push_back(static_cast<QObject*>(object));
+
+		this->UntypedObjectModel::insertObjects(untyped, index);
+	}
+
 	void removeObject(const T* object) { this->UntypedObjectModel::removeObject(object); }
 
 	static ObjectModel<T>* emptyInstance() {
 		return static_cast<ObjectModel<T>*>(UntypedObjectModel::emptyInstance());
 	}
 };
+
+// Collects objects that finish loading close together so they can be published in one batch,
+// usually with ObjectModel::insertObjects. A ready object is held back for at most
+// BATCH_MSECS, and the batch is published as soon as no tracked object is still loading.
+class UntypedReadyBatcher: public QObject {
+	Q_OBJECT;
+
+public:
+	static constexpr qint32 BATCH_MSECS = 50;
+
+	explicit UntypedReadyBatcher(QObject* parent = nullptr);
+
+	void addLoading(QObject* object);
+	// Moves a loading object into the batch. Returns false if the object was not loading.
+	bool setReady(QObject* object);
+	// Forgets an object, whether it is still loading or waiting in the batch.
+	void remove(QObject* object);
+	void clear();
+
+	// While held, a batch is not published early, for example while the initial set of
+	// objects is still being listed. Releasing the hold publishes the batch if nothing is loading.
+	void setHeld(bool held);
+
+	[[nodiscard]] bool isBatched(QObject* object) const;
+
+	void flush();
+
+protected:
+	virtual void publish(const QVector<QObject*>& objects) = 0;
+
+private:
+	QSet<QObject*> loading;
+	QVector<QObject*> batch;
+	QTimer timer;
+	bool held = false;
+};
+
+template <typename T>
+class ReadyBatcher: public UntypedReadyBatcher {
+public:
+	template <typename R>
+	explicit ReadyBatcher(R* receiver, void (R::*publish)(const QVector<T*>&))
+	    : UntypedReadyBatcher(receiver)
+	    , callback([=](const QVector<T*>& objects) { (receiver->*publish)(objects); }) {}
+
+protected:
+	void publish(const QVector<QObject*>& objects) override {
+		auto typed = QVector<T*>();
+		typed.reserve(objects.length());
+		for (auto* object: objects) typed.push_back(static_cast<T*>(object));
+
+		this->callback(typed);
+	}
+
+private:
+	std::function<void(const QVector<T*>&)> callback;
+};
@@ -0,0 +1,47 @@
+#include "triplebuffer.hpp"
+
+#include <qlogging.h>
+#include <qtest.h>
+#include <qtestcase.h>
+
+#include "../triplebuffer.hpp"
+
+void TestTripleBuffer::publishUpdate() {
+	auto tb = TripleBuffer<int>();
+
+	qInfo() << "checking update without a published value";
+	QVERIFY(!tb.update());
+	QCOMPARE(tb.readBuffer(), 0);
+
+	qInfo() << "publishing 1";
+	tb.writeBuffer() = 1;
+	tb.publish();
+	QVERIFY(tb.update());
+	QCOMPARE(tb.readBuffer(), 1);
+
+	qInfo() << "checking the value is only delivered once";
+	QVERIFY(!tb.update());
+	QCOMPARE(tb.readBuffer(), 1);
+}
+
+void TestTripleBuffer::latestWins() {
+	auto tb = TripleBuffer<int>();
+
+	qInfo() << "publishing 1,2,3 before reading";
+	for (auto i = 1; i <= 3; i++) {
+		tb.writeBuffer() = i;
+		tb.publish();
+	}
+
+	QVERIFY(tb.update());
+	QCOMPARE(tb.readBuffer(), 3);
+
+	qInfo() << "publishing 4 while 3 is being read";
+	tb.writeBuffer() = 4;
+	tb.publish();
+	QCOMPARE(tb.readBuffer(), 3);
+	QVERIFY(tb.update());
+	QCOMPARE(tb.readBuffer(), 4);
+}
+
+QTEST_MAIN(TestTripleBuffer);
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <qobject.h>
+#include <qtmetamacros.h>
+
+class TestTripleBuffer: public QObject {
+	Q_OBJECT;
+
+private slots:
+	static void publishUpdate();
+	static void latestWins();
+};
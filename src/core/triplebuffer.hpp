@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <qtypes.h>
+
+// Lock free single producer, single consumer triple buffer.
+//
+// The writer fills writeBuffer() and calls publish(), the reader calls update()
+// and reads readBuffer(). Neither side ever waits for the other, and the reader
+// always sees the most recently published value. Values published between two
+// updates are dropped.
+template <typename T>
+class TripleBuffer {
+public:
+	// writer side
+	[[nodiscard]] T& writeBuffer() { return this->slots[this->back]; }
+
+	void publish() {
+		auto old = this->middle.exchange(this->back | DIRTY, std::memory_order_acq_rel);
+		this->back = old & INDEX_MASK;
+	}
+
+	// reader side, returns true if a new value was published since the last update
+	bool update() {
+		if ((this->middle.load(std::memory_order_relaxed) & DIRTY) == 0) return false;
+		auto old = this->middle.exchange(this->front, std::memory_order_acq_rel);
+		this->front = old & INDEX_MASK;
+		return true;
+	}
+
+	[[nodiscard]] const T& readBuffer() const { return this->slots[this->front]; }
+
+private:
+	static constexpr quint8 INDEX_MASK = 0b011;
+	static constexpr quint8 DIRTY = 0b100;
+
+	std::array<T, 3> slots {};
+	quint8 front = 0;
+	std::atomic<quint8> middle = 1;
+	quint8 back = 2;
+};
@@ -1,5 +1,6 @@
 #include "dbusmenu.hpp"
 #include <algorithm>
+#include <utility>
 
 #include <qbytearray.h>
 #include <qcontainerfwd.h>
@@ -10,16 +11,19 @@
 #include <qdbuspendingcall.h>
 #include <qdbuspendingreply.h>
 #include <qdebug.h>
+#include <qhash.h>
 #include <qimage.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qnamespace.h>
 #include <qobject.h>
 #include <qqmllist.h>
+#include <qset.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 #include <qvariant.h>
 
+#include "../../core/asyncimage.hpp"
 #include "../../core/iconimageprovider.hpp"
 #include "../../core/qsmenu.hpp"
 #include "../../dbus/properties.hpp"
@@ -32,6 +36,16 @@ using namespace qs::menu;
 
 namespace qs::dbus::dbusmenu {
 
+namespace {
+
+// Depth covering both requests, where -1 is unlimited.
+qint32 mergeLayoutDepth(qint32 a, qint32 b) {
+	if (a == -1 || b == -1) return -1;
+	return std::max(a, b);
+}
+
+} // namespace
+
 DBusMenuItem::DBusMenuItem(qint32 id, DBusMenu* menu, DBusMenuItem* parentMenu)
     : QsMenuEntry(menu)
     , id(id)
@@ -319,6 +333,13 @@ DBusMenu::DBusMenu(const QString& service, const QString& path, QObject* parent)
 	    &DBusMenu::onLayoutUpdated
 	);
 
+	QObject::connect(
+	    this->interface,
+	    &DBusMenuInterface::ItemsPropertiesUpdated,
+	    this,
+	    &DBusMenu::onItemPropertiesUpdated
+	);
+
 	this->properties.setInterface(this->interface);
 	this->properties.updateAllViaGetAll();
 }
@@ -343,20 +364,42 @@ void DBusMenu::prepareToShow(qint32 item, qint32 depth) {
 }
 
 void DBusMenu::updateLayout(qint32 parent, qint32 depth) {
+	// Some programs send bursts of layout updates. Only one request per parent is kept in
+	// flight, and any number of updates requested meanwhile collapse into one more request.
+	auto request = this->layoutRequests.find(parent);
+	if (request != this->layoutRequests.end()) {
+		request->queuedDepth = request->queued ? mergeLayoutDepth(request->queuedDepth, depth) : depth;
+		request->queued = true;
+		return;
+	}
+
+	this->requestLayout(parent, depth);
+}
+
+void DBusMenu::requestLayout(qint32 parent, qint32 depth) {
+	this->layoutRequests.insert(parent, LayoutRequest {.depth = depth});
+
 	auto pending = this->interface->GetLayout(parent, depth, QStringList());
 	auto* call = new QDBusPendingCallWatcher(pending, this);
 
 	auto responseCallback = [this, parent, depth](QDBusPendingCallWatcher* call) {
 		const QDBusPendingReply<uint, DBusMenuLayout> reply = *call;
+		auto request = this->layoutRequests.take(parent);
 
 		if (reply.isError()) {
 			qCWarning(logDbusMenu) << "Error updating layout for menu" << parent << "of" << this
 			                       << reply.error();
+		} else if (request.queued && reply.argumentAt<0>() < this->layoutRevision) {
+			// a newer layout has been announced and will be requested below
+			qCDebug(logDbusMenu) << "Dropping outdated layout revision" << reply.argumentAt<0>()
+			                     << "for menu" << parent << "of" << this;
 		} else {
 			auto layout = reply.argumentAt<1>();
 			this->updateLayoutRecursive(layout, this->items.value(parent), depth);
 		}
 
+		if (request.queued) this->requestLayout(parent, request.queuedDepth);
+
 		delete call;
 	};
 
@@ -381,19 +424,24 @@ void DBusMenu::updateLayoutRecursive(
 	if (item == nullptr) return;
 
 	qCDebug(logDbusMenu) << "Updating layout recursively for" << this << "menu" << layout.id;
-	item->updateProperties(layout.properties);
+
+	if (layout.properties != item->layoutProperties) {
+		item->layoutProperties = layout.properties;
+		item->updateProperties(layout.properties);
+	}
 
 	if (depth != 0) {
 		auto childrenChanged = false;
+
+		auto layoutIds = QSet<qint32>();
+		layoutIds.reserve(layout.children.length());
+		for (const auto& child: layout.children) {
+			layoutIds.insert(child.id);
+		}
+
 		auto iter = item->mChildren.begin();
 		while (iter != item->mChildren.end()) {
-			auto existing = std::find_if(
-			    layout.children.begin(),
-			    layout.children.end(),
-			    [&](const DBusMenuLayout& layout) { return layout.id == *iter; }
-			);
-
-			if (existing == layout.children.end()) {
+			if (!layoutIds.contains(*iter)) {
 				qCDebug(logDbusMenu) << "Removing missing layout item" << this->items.value(*iter) << "from"
 				                     << item;
 				this->removeRecursive(*iter);
@@ -404,14 +452,27 @@ void DBusMenu::updateLayoutRecursive(
 			}
 		}
 
-		for (const auto& child: layout.children) {
-			if (item->mShowChildren && !item->mChildren.contains(child.id)) {
-				qCDebug(logDbusMenu) << "Creating new layout item" << child.id << "in" << item;
-				item->mChildren.push_back(child.id);
-				this->items.insert(child.id, nullptr);
+		if (item->mShowChildren) {
+			// children are kept in layout order, which may differ from the previous one
+			auto children = QVector<qint32>();
+			children.reserve(layout.children.length());
+
+			for (const auto& child: layout.children) {
+				if (!this->items.contains(child.id)) {
+					qCDebug(logDbusMenu) << "Creating new layout item" << child.id << "in" << item;
+					this->items.insert(child.id, nullptr);
+				}
+
+				children.push_back(child.id);
+			}
+
+			if (children != item->mChildren) {
+				item->mChildren = std::move(children);
 				childrenChanged = true;
 			}
+		}
 
+		for (const auto& child: layout.children) {
 			this->updateLayoutRecursive(child, item, depth - 1);
 		}
 
@@ -464,7 +525,9 @@ void DBusMenu::sendEvent(qint32 item, const QString& event) {
 
 DBusMenuItem* DBusMenu::menu() { return &this->rootItem; }
 
-void DBusMenu::onLayoutUpdated(quint32 /*unused*/, qint32 parent) {
+void DBusMenu::onLayoutUpdated(quint32 revision, qint32 parent) {
+	this->layoutRevision = std::max(this->layoutRevision, revision);
+
 	// note: spec says this is recursive
 	this->updateLayout(parent, -1);
 }
@@ -473,9 +536,11 @@ void DBusMenu::onItemPropertiesUpdated( // NOLINT
     const DBusMenuItemPropertiesList& updatedProps,
     const DBusMenuItemPropertyNamesList& removedProps
 ) {
+	// Items updated here no longer match their last layout, so the next layout must be applied.
 	for (const auto& propset: updatedProps) {
 		auto* item = this->items.value(propset.id);
 		if (item != nullptr) {
+			item->layoutProperties.clear();
 			item->updateProperties(propset.properties);
 		}
 	}
@@ -483,6 +548,7 @@ void DBusMenu::onItemPropertiesUpdated( // NOLINT
 	for (const auto& propset: removedProps) {
 		auto* item = this->items.value(propset.id);
 		if (item != nullptr) {
+			item->layoutProperties.clear();
 			item->updateProperties({}, propset.properties);
 		}
 	}
@@ -500,13 +566,23 @@ QDebug operator<<(QDebug debug, DBusMenu* menu) {
 	return debug;
 }
 
+DBusMenuPngImage::DBusMenuPngImage(QByteArray data, DBusMenuItem* parent)
+    : QsImageHandle(QQuickImageProvider::Image, parent)
+    , data(std::move(data)) {
+	this->decoded = AsyncImage::startShared(this->data, [data = this->data]() {
+		auto image = QImage();
+
+		if (!image.loadFromData(data, "PNG")) {
+			qCWarning(logDbusMenu) << "Failed to load dbusmenu item png";
+		}
+
+		return image;
+	});
+}
+
 QImage
 DBusMenuPngImage::requestImage(const QString& /*unused*/, QSize* size, const QSize& /*unused*/) {
-	auto image = QImage();
-
-	if (!image.loadFromData(this->data, "PNG")) {
-		qCWarning(logDbusMenu) << "Failed to load dbusmenu item png";
-	}
+	auto image = this->decoded->image();
 
 	if (size != nullptr) *size = image.size();
 	return image;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include <qbytearray.h>
 #include <qcontainerfwd.h>
 #include <qdebug.h>
@@ -13,6 +15,7 @@
 #include <qtmetamacros.h>
 #include <qtypes.h>
 
+#include "../../core/asyncimage.hpp"
 #include "../../core/imageprovider.hpp"
 #include "../../core/qsmenu.hpp"
 #include "../properties.hpp"
@@ -72,6 +75,8 @@ public:
 	qint32 id = 0;
 	QString mText;
 	QVector<qint32> mChildren;
+	// last property set received from a layout, used to skip unchanged items
+	QVariantMap layoutProperties;
 	bool mShowChildren = false;
 	bool childrenLoaded = false;
 	DBusMenu* menu = nullptr;
@@ -139,22 +144,36 @@ private slots:
 	);
 
 private:
+	struct LayoutRequest {
+		qint32 depth = 0;
+		// set if another update was requested while this one was in flight
+		bool queued = false;
+		qint32 queuedDepth = 0;
+	};
+
+	void requestLayout(qint32 parent, qint32 depth);
 	void updateLayoutRecursive(const DBusMenuLayout& layout, DBusMenuItem* parent, qint32 depth);
 
 	DBusMenuInterface* interface = nullptr;
+	// in flight GetLayout calls by parent id
+	QHash<qint32, LayoutRequest> layoutRequests;
+	// newest layout revision announced by LayoutUpdated
+	quint32 layoutRevision = 0;
 };
 
 QDebug operator<<(QDebug debug, DBusMenu* menu);
 
+// Decoded as soon as it is created. Items sending identical icons share one decoded image.
 class DBusMenuPngImage: public QsImageHandle {
 public:
-	explicit DBusMenuPngImage(QByteArray data, DBusMenuItem* parent)
-	    : QsImageHandle(QQuickImageProvider::Image, parent)
-	    , data(std::move(data)) {}
+	explicit DBusMenuPngImage(QByteArray data, DBusMenuItem* parent);
 
 	QImage requestImage(const QString& id, QSize* size, const QSize& requestedSize) override;
 
 	QByteArray data;
+
+private:
+	std::shared_ptr<AsyncImage> decoded;
 };
 
 class DBusMenuHandle;
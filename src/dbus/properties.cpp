@@ -1,10 +1,10 @@
 #include "properties.hpp"
-#include <algorithm>
 #include <utility>
 
 #include <qcontainerfwd.h>
 #include <qdbusabstractinterface.h>
 #include <qdbusargument.h>
+#include <qdbusconnection.h>
 #include <qdbuserror.h>
 #include <qdbusextratypes.h>
 #include <qdbusmessage.h>
@@ -12,6 +12,7 @@
 #include <qdbuspendingcall.h>
 #include <qdbuspendingreply.h>
 #include <qdebug.h>
+#include <qhash.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qmetatype.h>
@@ -20,8 +21,6 @@
 #include <qtmetamacros.h>
 #include <qvariant.h>
 
-#include "dbus_properties.h"
-
 Q_LOGGING_CATEGORY(logDbusProperties, "quickshell.dbus.properties", QtWarningMsg);
 
 namespace qs::dbus {
@@ -111,18 +110,26 @@ void asyncReadPropertyInternal(
 	QObject::connect(call, &QDBusPendingCallWatcher::finished, &interface, responseCallback);
 }
 
-void AbstractDBusProperty::tryUpdate(const QVariant& variant) {
+bool AbstractDBusProperty::tryUpdate(const QVariant& variant) {
+	// the first value received always notifies, as it changes exists()
+	auto skipUnchanged = this->mExists && !this->alwaysNotify;
 	this->mExists = true;
 
-	auto error = this->read(variant);
+	auto changed = false;
+	auto error = this->read(variant, skipUnchanged, changed);
 	if (error.isValid()) {
 		qCWarning(logDbusProperties).noquote()
 		    << "Error demarshalling property update for" << this->toString();
 		qCWarning(logDbusProperties) << error;
-	} else {
+	} else if (changed) {
 		qCDebug(logDbusProperties).noquote()
 		    << "Updated property" << this->toString() << "to" << this->valueString();
+	} else {
+		qCDebug(logDbusProperties).noquote()
+		    << "Ignoring unchanged update of property" << this->toString();
 	}
+
+	return changed;
 }
 
 void AbstractDBusProperty::update() {
@@ -139,8 +146,10 @@ void AbstractDBusProperty::update() {
 
 		qCDebug(logDbusProperties).noquote() << "Updating property" << propStr;
 
-		auto pendingCall =
-		    this->group->propertyInterface->Get(this->group->interface->interface(), this->name);
+		auto pendingCall = this->group->callProperties(
+		    "Get",
+		    {this->group->interface->interface(), this->name}
+		);
 
 		auto* call = new QDBusPendingCallWatcher(pendingCall, this);
 
@@ -150,8 +159,8 @@ void AbstractDBusProperty::update() {
 			if (reply.isError()) {
 				qCWarning(logDbusProperties).noquote() << "Error updating property" << propStr;
 				qCWarning(logDbusProperties) << reply.error();
-			} else {
-				this->tryUpdate(reply.value().variant());
+			} else if (this->tryUpdate(reply.value().variant())) {
+				emit this->group->propertiesUpdated();
 			}
 
 			delete call;
@@ -175,10 +184,11 @@ void AbstractDBusProperty::write() {
 
 		qCDebug(logDbusProperties).noquote() << "Writing property" << propStr;
 
-		auto pendingCall = this->group->propertyInterface->Set(
-		    this->group->interface->interface(),
-		    this->name,
-		    QDBusVariant(this->serialize())
+		auto pendingCall = this->group->callProperties(
+		    "Set",
+		    {this->group->interface->interface(),
+		     this->name,
+		     QVariant::fromValue(QDBusVariant(this->serialize()))}
 		);
 
 		auto* call = new QDBusPendingCallWatcher(pendingCall, this);
@@ -199,45 +209,168 @@ void AbstractDBusProperty::write() {
 
 bool AbstractDBusProperty::exists() const { return this->mExists; }
 
+void AbstractDBusProperty::setAlwaysNotify(bool alwaysNotify) { this->alwaysNotify = alwaysNotify; }
+
 QString AbstractDBusProperty::toString() const {
 	const QString group = this->group == nullptr ? "{ NO GROUP }" : this->group->toString();
 	return group + ':' + this->name;
 }
 
+DBusPropertiesService::DBusPropertiesService(
+    DBusPropertiesDispatcher* dispatcher,
+    QString service,
+    QObject* parent
+)
+    : QObject(parent)
+    , dispatcher(dispatcher)
+    , service(std::move(service)) {
+	qCDebug(logDbusProperties) << "Subscribing to property changes of" << this->service;
+
+	// an empty path matches every object of the service
+	auto connected = this->dispatcher->connection.connect(
+	    this->service,
+	    QString(),
+	    "org.freedesktop.DBus.Properties",
+	    "PropertiesChanged",
+	    this,
+	    SLOT(onPropertiesChanged(QString, QVariantMap, QStringList, QDBusMessage))
+	);
+
+	if (!connected) {
+		qCWarning(logDbusProperties) << "Failed to subscribe to property changes of" << this->service;
+	}
+}
+
+DBusPropertiesService::~DBusPropertiesService() {
+	qCDebug(logDbusProperties) << "Unsubscribing from property changes of" << this->service;
+
+	this->dispatcher->connection.disconnect(
+	    this->service,
+	    QString(),
+	    "org.freedesktop.DBus.Properties",
+	    "PropertiesChanged",
+	    this,
+	    SLOT(onPropertiesChanged(QString, QVariantMap, QStringList, QDBusMessage))
+	);
+}
+
+void DBusPropertiesService::onPropertiesChanged(
+    const QString& interfaceName,
+    const QVariantMap& changedProperties,
+    const QStringList& invalidatedProperties,
+    const QDBusMessage& message
+) {
+	auto iter = this->groups.constFind({message.path(), interfaceName});
+	if (iter == this->groups.cend()) return;
+
+	// copied as an update may remove groups
+	auto groups = *iter;
+	for (auto* group: groups) {
+		group->onPropertiesChanged(interfaceName, changedProperties, invalidatedProperties);
+	}
+}
+
+DBusPropertiesDispatcher::DBusPropertiesDispatcher(QDBusConnection connection, QObject* parent)
+    : QObject(parent)
+    , connection(std::move(connection)) {}
+
+void DBusPropertiesDispatcher::addGroup(
+    DBusPropertyGroup* group,
+    const QDBusAbstractInterface& interface
+) {
+	this->removeGroup(group);
+
+	auto key = GroupKey {
+	    .service = interface.service(),
+	    .path = interface.path(),
+	    .interface = interface.interface(),
+	};
+
+	auto*& service = this->services[key.service];
+	if (service == nullptr) service = new DBusPropertiesService(this, key.service, this);
+
+	service->groups[{key.path, key.interface}].push_back(group);
+	this->groupKeys.insert(group, key);
+}
+
+void DBusPropertiesDispatcher::removeGroup(DBusPropertyGroup* group) {
+	auto keyIter = this->groupKeys.find(group);
+	if (keyIter == this->groupKeys.end()) return;
+
+	auto key = *keyIter;
+	this->groupKeys.erase(keyIter);
+
+	auto serviceIter = this->services.find(key.service);
+	if (serviceIter == this->services.end()) return;
+	auto* service = *serviceIter;
+
+	auto groupsIter = service->groups.find({key.path, key.interface});
+	if (groupsIter != service->groups.end()) {
+		groupsIter->removeOne(group);
+		if (groupsIter->isEmpty()) service->groups.erase(groupsIter);
+	}
+
+	if (service->groups.isEmpty()) {
+		this->services.erase(serviceIter);
+		delete service;
+	}
+}
+
+DBusPropertiesDispatcher* DBusPropertiesDispatcher::forConnection(const QDBusConnection& connection
+) {
+	static QHash<QString, DBusPropertiesDispatcher*> dispatchers; // NOLINT
+
+	auto*& dispatcher = dispatchers[connection.name()];
+	if (dispatcher == nullptr) dispatcher = new DBusPropertiesDispatcher(connection);
+
+	return dispatcher;
+}
+
 DBusPropertyGroup::DBusPropertyGroup(QVector<AbstractDBusProperty*> properties, QObject* parent)
     : QObject(parent)
-    , properties(std::move(properties)) {}
+    , properties(std::move(properties)) {
+	for (auto* property: this->properties) {
+		this->propertiesByName.insert(property->name, property);
+	}
+}
+
+DBusPropertyGroup::~DBusPropertyGroup() {
+	if (this->dispatcher != nullptr) this->dispatcher->removeGroup(this);
+}
 
 void DBusPropertyGroup::setInterface(QDBusAbstractInterface* interface) {
-	if (this->interface != nullptr) {
-		delete this->propertyInterface;
-		this->propertyInterface = nullptr;
+	if (this->dispatcher != nullptr) {
+		this->dispatcher->removeGroup(this);
+		this->dispatcher = nullptr;
 	}
 
-	if (interface != nullptr) {
-		this->interface = interface;
-
-		this->propertyInterface = new DBusPropertiesInterface(
-		    interface->service(),
-		    interface->path(),
-		    interface->connection(),
-		    this
-		);
+	this->interface = interface;
 
-		QObject::connect(
-		    this->propertyInterface,
-		    &DBusPropertiesInterface::PropertiesChanged,
-		    this,
-		    &DBusPropertyGroup::onPropertiesChanged
-		);
+	if (interface != nullptr) {
+		this->dispatcher = DBusPropertiesDispatcher::forConnection(interface->connection());
+		this->dispatcher->addGroup(this, *interface);
 	}
 }
 
 void DBusPropertyGroup::attachProperty(AbstractDBusProperty* property) {
 	this->properties.append(property);
+	this->propertiesByName.insert(property->name, property);
 	property->group = this;
 }
 
+QDBusPendingCall
+DBusPropertyGroup::callProperties(const QString& method, const QVariantList& arguments) {
+	auto message = QDBusMessage::createMethodCall(
+	    this->interface->service(),
+	    this->interface->path(),
+	    "org.freedesktop.DBus.Properties",
+	    method
+	);
+
+	message.setArguments(arguments);
+	return this->interface->connection().asyncCall(message);
+}
+
 void DBusPropertyGroup::updateAllDirect() {
 	qCDebug(logDbusProperties).noquote()
 	    << "Updating all properties of" << this->toString() << "via individual queries";
@@ -259,7 +392,7 @@ void DBusPropertyGroup::updateAllViaGetAll() {
 		qFatal() << "Attempted to update properties of disconnected property group";
 	}
 
-	auto pendingCall = this->propertyInterface->GetAll(this->interface->interface());
+	auto pendingCall = this->callProperties("GetAll", {this->interface->interface()});
 	auto* call = new QDBusPendingCallWatcher(pendingCall, this);
 
 	auto responseCallback = [this](QDBusPendingCallWatcher* call) {
@@ -272,7 +405,10 @@ void DBusPropertyGroup::updateAllViaGetAll() {
 		} else {
 			qCDebug(logDbusProperties).noquote()
 			    << "Received GetAll property set for" << this->toString();
-			this->updatePropertySet(reply.value(), true);
+
+			if (this->updatePropertySet(reply.value(), true)) {
+				emit this->propertiesUpdated();
+			}
 		}
 
 		delete call;
@@ -282,19 +418,17 @@ void DBusPropertyGroup::updateAllViaGetAll() {
 	QObject::connect(call, &QDBusPendingCallWatcher::finished, this, responseCallback);
 }
 
-void DBusPropertyGroup::updatePropertySet(const QVariantMap& properties, bool complainMissing) {
+bool DBusPropertyGroup::updatePropertySet(const QVariantMap& properties, bool complainMissing) {
+	auto changed = false;
+
 	for (const auto [name, value]: properties.asKeyValueRange()) {
-		auto prop = std::find_if(
-		    this->properties.begin(),
-		    this->properties.end(),
-		    [&name](AbstractDBusProperty* prop) { return prop->name == name; }
-		);
+		auto* prop = this->propertiesByName.value(name);
 
-		if (prop == this->properties.end()) {
+		if (prop == nullptr) {
 			qCDebug(logDbusProperties) << "Ignoring untracked property update" << name << "for"
 			                           << this->toString();
-		} else {
-			(*prop)->tryUpdate(value);
+		} else if (prop->tryUpdate(value)) {
+			changed = true;
 		}
 	}
 
@@ -306,6 +440,8 @@ void DBusPropertyGroup::updatePropertySet(const QVariantMap& properties, bool co
 			}
 		}
 	}
+
+	return changed;
 }
 
 QString DBusPropertyGroup::toString() const {
@@ -327,21 +463,19 @@ void DBusPropertyGroup::onPropertiesChanged(
 	    << "Received property change set and invalidations for" << this->toString();
 
 	for (const auto& name: invalidatedProperties) {
-		auto prop = std::find_if(
-		    this->properties.begin(),
-		    this->properties.end(),
-		    [&name](AbstractDBusProperty* prop) { return prop->name == name; }
-		);
+		auto* prop = this->propertiesByName.value(name);
 
-		if (prop == this->properties.end()) {
+		if (prop == nullptr) {
 			qCDebug(logDbusProperties) << "Ignoring untracked property invalidation" << name << "for"
 			                           << this;
 		} else {
-			(*prop)->update();
+			prop->update();
 		}
 	}
 
-	this->updatePropertySet(changedProperties, false);
+	if (this->updatePropertySet(changedProperties, false)) {
+		emit this->propertiesUpdated();
+	}
 }
 
 } // namespace qs::dbus
@@ -1,24 +1,28 @@
 #pragma once
 
+#include <concepts>
 #include <functional>
 #include <utility>
 
 #include <qcontainerfwd.h>
 #include <qdbusabstractinterface.h>
+#include <qdbusconnection.h>
 #include <qdbuserror.h>
 #include <qdbusextratypes.h>
+#include <qdbusmessage.h>
 #include <qdbuspendingcall.h>
 #include <qdbusreply.h>
 #include <qdbusservicewatcher.h>
 #include <qdebug.h>
+#include <qhash.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qobject.h>
+#include <qpair.h>
+#include <qtclasshelpermacros.h>
 #include <qtmetamacros.h>
 #include <qvariant.h>
 
-class DBusPropertiesInterface;
-
 Q_DECLARE_LOGGING_CATEGORY(logDbusProperties);
 
 namespace qs::dbus {
@@ -94,6 +98,10 @@ public:
 	[[nodiscard]] QString toString() const;
 	[[nodiscard]] virtual QString valueString() = 0;
 
+	// If true, changed is emitted for every update received from the remote,
+	// even if the value is equal to the current one. Defaults to false.
+	void setAlwaysNotify(bool alwaysNotify);
+
 public slots:
 	void update();
 	void write();
@@ -102,11 +110,14 @@ signals:
 	void changed();
 
 protected:
-	virtual QDBusError read(const QVariant& variant) = 0;
+	// If skipUnchanged is true and the read value is equal to the current one the value
+	// is left as is. changed is set if the value was updated.
+	virtual QDBusError read(const QVariant& variant, bool skipUnchanged, bool& changed) = 0;
 	virtual QVariant serialize() = 0;
 
 private:
-	void tryUpdate(const QVariant& variant);
+	// returns true if the value changed
+	bool tryUpdate(const QVariant& variant);
 
 	DBusPropertyGroup* group = nullptr;
 
@@ -114,10 +125,70 @@ private:
 	QMetaType type;
 	bool required;
 	bool mExists = false;
+	bool alwaysNotify = false;
 
 	friend class DBusPropertyGroup;
 };
 
+class DBusPropertiesDispatcher;
+
+// Receives PropertiesChanged signals from a single service.
+class DBusPropertiesService: public QObject {
+	Q_OBJECT;
+
+public:
+	explicit DBusPropertiesService(
+	    DBusPropertiesDispatcher* dispatcher,
+	    QString service,
+	    QObject* parent = nullptr
+	);
+
+	~DBusPropertiesService() override;
+	Q_DISABLE_COPY_MOVE(DBusPropertiesService);
+
+	// keyed by (path, interface)
+	QHash<QPair<QString, QString>, QVector<DBusPropertyGroup*>> groups;
+
+private slots:
+	void onPropertiesChanged(
+	    const QString& interfaceName,
+	    const QVariantMap& changedProperties,
+	    const QStringList& invalidatedProperties,
+	    const QDBusMessage& message
+	);
+
+private:
+	DBusPropertiesDispatcher* dispatcher;
+	QString service;
+};
+
+// Shares a single PropertiesChanged subscription per service between every property
+// group on a connection, and routes signals to groups by object path and interface.
+class DBusPropertiesDispatcher: public QObject {
+	Q_OBJECT;
+
+public:
+	explicit DBusPropertiesDispatcher(QDBusConnection connection, QObject* parent = nullptr);
+
+	void addGroup(DBusPropertyGroup* group, const QDBusAbstractInterface& interface);
+	void removeGroup(DBusPropertyGroup* group);
+
+	static DBusPropertiesDispatcher* forConnection(const QDBusConnection& connection);
+
+private:
+	struct GroupKey {
+		QString service;
+		QString path;
+		QString interface;
+	};
+
+	QDBusConnection connection;
+	QHash<QString, DBusPropertiesService*> services;
+	QHash<DBusPropertyGroup*, GroupKey> groupKeys;
+
+	friend class DBusPropertiesService;
+};
+
 class DBusPropertyGroup: public QObject {
 	Q_OBJECT;
 
@@ -127,6 +198,9 @@ public:
 	    QObject* parent = nullptr
 	);
 
+	~DBusPropertyGroup() override;
+	Q_DISABLE_COPY_MOVE(DBusPropertyGroup);
+
 	void setInterface(QDBusAbstractInterface* interface);
 	void attachProperty(AbstractDBusProperty* property);
 	void updateAllDirect();
@@ -135,6 +209,9 @@ public:
 
 signals:
 	void getAllFinished();
+	/// Emitted once after each batch of property updates that changed at least one value,
+	/// after the changed signals of the individual properties.
+	void propertiesUpdated();
 
 private slots:
 	void onPropertiesChanged(
@@ -144,13 +221,17 @@ private slots:
 	);
 
 private:
-	void updatePropertySet(const QVariantMap& properties, bool complainMissing);
+	// returns true if any property changed
+	bool updatePropertySet(const QVariantMap& properties, bool complainMissing);
+	QDBusPendingCall callProperties(const QString& method, const QVariantList& arguments);
 
-	DBusPropertiesInterface* propertyInterface = nullptr;
+	DBusPropertiesDispatcher* dispatcher = nullptr;
 	QDBusAbstractInterface* interface = nullptr;
 	QVector<AbstractDBusProperty*> properties;
+	QHash<QString, AbstractDBusProperty*> propertiesByName;
 
 	friend class AbstractDBusProperty;
+	friend class DBusPropertiesService;
 };
 
 template <typename T>
@@ -190,11 +271,16 @@ public:
 	}
 
 protected:
-	QDBusError read(const QVariant& variant) override {
+	QDBusError read(const QVariant& variant, bool skipUnchanged, bool& changed) override {
 		auto result = demarshallVariant<T>(variant);
 
 		if (result.isValid()) {
+			if constexpr (std::equality_comparable<T>) {
+				if (skipUnchanged && result.value == this->value) return result.error;
+			}
+
 			this->set(std::move(result.value));
+			changed = true;
 		}
 
 		return result.error;
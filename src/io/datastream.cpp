@@ -1,11 +1,24 @@
 #include "datastream.hpp"
 #include <algorithm>
+#include <cstring>
 #include <utility>
 
+#include <qbytearray.h>
+#include <qbytearrayview.h>
+#include <qendian.h>
+#include <qjsondocument.h>
+#include <qlist.h>
 #include <qlocalsocket.h>
+#include <qlogging.h>
+#include <qloggingcategory.h>
 #include <qobject.h>
+#include <qstring.h>
+#include <qtimer.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
+#include <qvariant.h>
+
+Q_LOGGING_CATEGORY(logDataStream, "quickshell.io.datastream", QtWarningMsg);
 
 DataStreamParser* DataStream::reader() const { return this->mReader; }
 
@@ -40,62 +53,184 @@ void DataStream::onBytesAvailable() {
 	this->mReader->parseBytes(buf, this->buffer);
 }
 
+bool DataStreamParser::raw() const { return this->mRaw; }
+
+void DataStreamParser::setRaw(bool raw) {
+	if (raw == this->mRaw) return;
+	this->mRaw = raw;
+	emit this->rawChanged();
+}
+
+void DataStreamParser::emitData(QByteArrayView data) {
+	if (this->mRaw) emit this->readBytes(data.toByteArray());
+	else emit this->read(QString::fromUtf8(data));
+}
+
+namespace {
+
+// Finds the first occurrence of marker in data at or after from, or -1.
+// The first byte is located with memchr (vectorized in any reasonable libc),
+// and the rest of the marker is only compared on a first byte hit.
+qsizetype findMarker(QByteArrayView data, QByteArrayView marker, qsizetype from) {
+	if (data.size() - from < marker.size()) return -1;
+
+	const auto* begin = data.data();
+	const auto* end = begin + data.size() - marker.size() + 1; // NOLINT
+	const auto* cursor = begin + from;                         // NOLINT
+	auto first = marker.front();
+	auto restLen = marker.size() - 1;
+
+	while (cursor < end) {
+		const auto* hit = static_cast<const char*>(std::memchr(cursor, first, end - cursor));
+		if (hit == nullptr) break;
+
+		if (restLen == 0 || std::memcmp(hit + 1, marker.data() + 1, restLen) == 0) { // NOLINT
+			return hit - begin;
+		}
+
+		cursor = hit + 1; // NOLINT
+	}
+
+	return -1;
+}
+
+// Calls callback with each chunk of buffer + incoming terminated by marker, then
+// leaves the unterminated remainder in buffer. incoming and buffer may be the same array.
+template <typename F>
+void splitBytes(QByteArray& incoming, QByteArray& buffer, QByteArrayView marker, F callback) {
+	auto mlen = marker.size();
+
+	auto aliased = &incoming == &buffer;
+	auto carry = !aliased && !buffer.isEmpty();
+	auto data = QByteArrayView(incoming);
+	qsizetype start = 0;
+
+	// The buffer never contains a full marker, but it may end with a partial one
+	// that is completed by the start of the incoming data.
+	if (carry && mlen > 1) {
+		auto blen = buffer.size();
+		auto bview = QByteArrayView(buffer);
+
+		for (auto i = blen - std::min(blen, mlen - 1); i < blen; i++) {
+			auto bufferPart = blen - i;
+			auto incomingPart = mlen - bufferPart;
+			if (incomingPart > data.size()) continue;
+
+			if (bview.sliced(i) == marker.first(bufferPart)
+			    && data.first(incomingPart) == marker.sliced(bufferPart))
+			{
+				callback(bview.first(i));
+				buffer.clear();
+				carry = false;
+				start = incomingPart;
+				break;
+			}
+		}
+	}
+
+	qsizetype next = -1;
+	while ((next = findMarker(data, marker, start)) != -1) {
+		auto slice = data.sliced(start, next - start);
+
+		if (carry) {
+			// only the first slice can have data left over from a previous read
+			buffer.append(slice);
+			callback(buffer);
+			buffer.clear();
+			carry = false;
+		} else {
+			callback(slice);
+		}
+
+		start = next + mlen;
+	}
+
+	if (carry) {
+		buffer.append(incoming);
+	} else if (aliased) {
+		buffer.remove(0, start);
+	} else {
+		// Dropping the front of a QByteArray only moves its begin pointer, so the
+		// remainder is carried over without copying the incoming data.
+		incoming.remove(0, start);
+		buffer = std::move(incoming);
+	}
+}
+
+// Decodes a JSON object or array without copying the input.
+// Returns an invalid variant and logs a warning if decoding fails.
+QVariant decodeJson(QByteArrayView data) {
+	auto raw = QByteArray::fromRawData(data.data(), data.size());
+	auto error = QJsonParseError();
+	auto document = QJsonDocument::fromJson(raw, &error);
+
+	if (error.error != QJsonParseError::NoError) {
+		qCWarning(logDataStream) << "Failed to parse JSON:" << error.errorString() << "at offset"
+		                         << error.offset;
+		return QVariant();
+	}
+
+	return document.toVariant();
+}
+
+} // namespace
+
+SplitParser::SplitParser(QObject* parent): DataStreamParser(parent) {
+	this->batchTimer.setSingleShot(true);
+	QObject::connect(&this->batchTimer, &QTimer::timeout, this, &SplitParser::flushBatch);
+}
+
 void SplitParser::parseBytes(QByteArray& incoming, QByteArray& buffer) {
+	this->parseChunks(incoming, buffer);
+
+	if (this->batch.isEmpty()) return;
+
+	if (this->mBatchInterval <= 0) this->flushBatch();
+	else if (!this->batchTimer.isActive()) this->batchTimer.start(this->mBatchInterval);
+}
+
+void SplitParser::parseChunks(QByteArray& incoming, QByteArray& buffer) {
 	if (this->mSplitMarker.isEmpty()) {
 		if (!buffer.isEmpty()) {
-			emit this->read(QString(buffer));
+			this->emitChunk(buffer);
 			buffer.clear();
 		}
 
-		emit this->read(QString(incoming));
+		this->emitChunk(incoming);
 		return;
 	}
 
 	// make sure we dont miss any delimiters in the buffer if the delimiter changes
 	if (this->mSplitMarkerChanged) {
 		this->mSplitMarkerChanged = false;
-		this->parseBytes(buffer, buffer);
+		this->parseChunks(buffer, buffer);
 	}
 
-	auto marker = this->mSplitMarker.toUtf8();
-	auto mlen = marker.length();
-
-	auto blen = buffer.size();
-	auto ilen = incoming.size();
-
-	qsizetype start = &incoming == &buffer ? 0 : -blen;
-	for (auto readi = -std::min(blen, mlen - 1); readi <= ilen - mlen; readi++) {
-		for (auto marki = 0; marki < mlen; marki++) {
-			qint8 byte; // NOLINT
-			if (readi + marki < 0) byte = buffer[blen + readi + marki];
-			else byte = incoming[readi + marki];
+	splitBytes(incoming, buffer, this->mSplitMarkerBytes, [this](QByteArrayView chunk) {
+		this->emitChunk(chunk);
+	});
+}
 
-			if (byte != marker[marki]) goto fail;
-		}
+void SplitParser::emitChunk(QByteArrayView chunk) {
+	if (!this->mBatched || this->mRaw) {
+		this->emitData(chunk);
+		return;
+	}
 
-		{
-			QByteArray slice;
-			if (start < 0) slice = buffer.sliced(0, std::min(blen, blen + readi));
-			if (readi > 0) {
-				auto sstart = std::max(static_cast<qsizetype>(0), start);
-				slice.append(incoming.sliced(sstart, readi - sstart));
-			}
-			readi += mlen;
-			start = readi;
-			emit this->read(QString(slice));
-		}
+	this->batch.push_back(QString::fromUtf8(chunk));
 
-	fail:;
+	if (this->mMaxBatchSize > 0 && this->batch.length() >= this->mMaxBatchSize) {
+		this->flushBatch();
 	}
+}
 
-	if (start < 0) {
-		buffer.append(incoming);
-	} else {
-		// Will break the init case if inlined. Must be before clear.
-		auto slice = incoming.sliced(start);
-		buffer.clear();
-		buffer.insert(0, slice);
-	}
+void SplitParser::flushBatch() {
+	this->batchTimer.stop();
+	if (this->batch.isEmpty()) return;
+
+	auto batch = std::move(this->batch);
+	this->batch = QList<QString>();
+	emit this->readBatch(batch);
 }
 
 QString SplitParser::splitMarker() const { return this->mSplitMarker; }
@@ -104,6 +239,156 @@ void SplitParser::setSplitMarker(QString marker) {
 	if (marker == this->mSplitMarker) return;
 
 	this->mSplitMarker = std::move(marker);
+	this->mSplitMarkerBytes = this->mSplitMarker.toUtf8();
 	this->mSplitMarkerChanged = true;
 	emit this->splitMarkerChanged();
 }
+
+bool SplitParser::batched() const { return this->mBatched; }
+
+void SplitParser::setBatched(bool batched) {
+	if (batched == this->mBatched) return;
+	this->mBatched = batched;
+	if (!batched) this->flushBatch();
+	emit this->batchedChanged();
+}
+
+qint32 SplitParser::maxBatchSize() const { return this->mMaxBatchSize; }
+
+void SplitParser::setMaxBatchSize(qint32 maxBatchSize) {
+	if (maxBatchSize == this->mMaxBatchSize) return;
+	this->mMaxBatchSize = maxBatchSize;
+	emit this->maxBatchSizeChanged();
+
+	if (maxBatchSize > 0 && this->batch.length() >= maxBatchSize) this->flushBatch();
+}
+
+qint32 SplitParser::batchInterval() const { return this->mBatchInterval; }
+
+void SplitParser::setBatchInterval(qint32 batchInterval) {
+	if (batchInterval == this->mBatchInterval) return;
+	this->mBatchInterval = batchInterval;
+	emit this->batchIntervalChanged();
+
+	if (batchInterval <= 0) this->flushBatch();
+}
+
+void JsonLineParser::parseBytes(QByteArray& incoming, QByteArray& buffer) {
+	splitBytes(incoming, buffer, "\n", [this](QByteArrayView line) {
+		if (line.trimmed().isEmpty()) return;
+
+		auto value = decodeJson(line);
+		if (value.isValid()) emit this->readJson(value);
+	});
+}
+
+void LengthPrefixedParser::parseBytes(QByteArray& incoming, QByteArray& buffer) {
+	if (buffer.isEmpty()) buffer = std::move(incoming);
+	else if (&incoming != &buffer) buffer.append(incoming);
+
+	auto headerSize = this->effectiveHeaderSize();
+	auto data = QByteArrayView(buffer);
+	qsizetype start = 0;
+
+	while (data.size() - start >= headerSize) {
+		auto length = this->readLength(data.data() + start); // NOLINT
+
+		if (length > static_cast<quint64>(this->mMaxLength)) {
+			qCWarning(logDataStream) << "Discarding buffered data of" << this
+			                         << "after reading a payload length of" << length
+			                         << "which exceeds maxLength" << this->mMaxLength;
+			buffer.clear();
+			return;
+		}
+
+		auto available = static_cast<quint64>(data.size() - start - headerSize);
+		if (length > available) break;
+
+		this->emitPayload(data.sliced(start + headerSize, static_cast<qsizetype>(length)));
+		start += headerSize + static_cast<qsizetype>(length);
+	}
+
+	buffer.remove(0, start);
+}
+
+qsizetype LengthPrefixedParser::effectiveHeaderSize() const {
+	auto minimum = this->mLengthOffset + this->mLengthSize;
+	return std::max(this->mHeaderSize, minimum);
+}
+
+quint64 LengthPrefixedParser::readLength(const char* header) const {
+	const auto* field = header + this->mLengthOffset; // NOLINT
+
+	switch (this->mLengthSize) {
+	case 1: return qFromUnaligned<quint8>(field);
+	case 2:
+		return this->mBigEndian ? qFromBigEndian<quint16>(field) : qFromLittleEndian<quint16>(field);
+	case 8:
+		return this->mBigEndian ? qFromBigEndian<quint64>(field) : qFromLittleEndian<quint64>(field);
+	default:
+		return this->mBigEndian ? qFromBigEndian<quint32>(field) : qFromLittleEndian<quint32>(field);
+	}
+}
+
+void LengthPrefixedParser::emitPayload(QByteArrayView payload) {
+	if (this->mJson) {
+		auto value = decodeJson(payload);
+		if (value.isValid()) emit this->readJson(value);
+	} else {
+		this->emitData(payload);
+	}
+}
+
+qint32 LengthPrefixedParser::lengthSize() const { return this->mLengthSize; }
+
+void LengthPrefixedParser::setLengthSize(qint32 lengthSize) {
+	if (lengthSize == this->mLengthSize) return;
+
+	if (lengthSize != 1 && lengthSize != 2 && lengthSize != 4 && lengthSize != 8) {
+		qCWarning(logDataStream) << "Unsupported length size" << lengthSize << "for" << this;
+		return;
+	}
+
+	this->mLengthSize = lengthSize;
+	emit this->lengthSizeChanged();
+}
+
+qint32 LengthPrefixedParser::lengthOffset() const { return this->mLengthOffset; }
+
+void LengthPrefixedParser::setLengthOffset(qint32 lengthOffset) {
+	if (lengthOffset == this->mLengthOffset || lengthOffset < 0) return;
+	this->mLengthOffset = lengthOffset;
+	emit this->lengthOffsetChanged();
+}
+
+qint32 LengthPrefixedParser::headerSize() const { return this->mHeaderSize; }
+
+void LengthPrefixedParser::setHeaderSize(qint32 headerSize) {
+	if (headerSize == this->mHeaderSize || headerSize < 0) return;
+	this->mHeaderSize = headerSize;
+	emit this->headerSizeChanged();
+}
+
+bool LengthPrefixedParser::bigEndian() const { return this->mBigEndian; }
+
+void LengthPrefixedParser::setBigEndian(bool bigEndian) {
+	if (bigEndian == this->mBigEndian) return;
+	this->mBigEndian = bigEndian;
+	emit this->bigEndianChanged();
+}
+
+bool LengthPrefixedParser::json() const { return this->mJson; }
+
+void LengthPrefixedParser::setJson(bool json) {
+	if (json == this->mJson) return;
+	this->mJson = json;
+	emit this->jsonChanged();
+}
+
+qint64 LengthPrefixedParser::maxLength() const { return this->mMaxLength; }
+
+void LengthPrefixedParser::setMaxLength(qint64 maxLength) {
+	if (maxLength == this->mMaxLength || maxLength < 1) return;
+	this->mMaxLength = maxLength;
+	emit this->maxLengthChanged();
+}
@@ -1,14 +1,22 @@
 #pragma once
 
 #include <qbytearray.h>
+#include <qbytearrayview.h>
+#include <qlist.h>
 #include <qlocalsocket.h>
+#include <qloggingcategory.h>
 #include <qobject.h>
 #include <qqmlintegration.h>
+#include <qstring.h>
+#include <qtimer.h>
 #include <qtmetamacros.h>
+#include <qtypes.h>
 #include <qvariant.h>
 
 class DataStreamParser;
 
+Q_DECLARE_LOGGING_CATEGORY(logDataStream);
+
 ///! Data source that can be streamed into a parser.
 /// See also: @@DataStreamParser
 class DataStream: public QObject {
@@ -46,6 +54,11 @@ protected:
 /// See also: @@DataStream, @@SplitParser.
 class DataStreamParser: public QObject {
 	Q_OBJECT;
+	/// If true, data is emitted as an `ArrayBuffer` via @@readBytes() instead of being decoded
+	/// as UTF-8 and emitted via @@read(). Use this for binary data. Defaults to false.
+	///
+	/// Parsers that decode structured data, such as @@JsonLineParser, ignore this property.
+	Q_PROPERTY(bool raw READ raw WRITE setRaw NOTIFY rawChanged);
 	QML_ELEMENT;
 	QML_UNCREATABLE("base class");
 
@@ -55,34 +68,218 @@ public:
 	// the buffer will be sent in both slots if there is data remaining from a previous parser
 	virtual void parseBytes(QByteArray& incoming, QByteArray& buffer) = 0;
 
+	[[nodiscard]] bool raw() const;
+	void setRaw(bool raw);
+
 signals:
 	/// Emitted when data is read from the stream.
 	void read(QString data);
+	/// Emitted instead of @@read() when data is read from the stream and @@raw is true.
+	void readBytes(QByteArray data);
+
+	void rawChanged();
+
+protected:
+	// emits read or readBytes depending on the raw property
+	void emitData(QByteArrayView data);
+
+	bool mRaw = false;
 };
 
 ///! Parser for delimited data streams.
 /// Parser for delimited data streams. @@read() is emitted once per delimited chunk of the stream.
+///
+/// When a stream produces many chunks at once, @@batched can be used to deliver them in
+/// a single @@readBatch() call, which is far cheaper than a signal handler invocation per chunk.
+/// ```qml
+/// SplitParser {
+///   batched: true
+///   onReadBatch: lines => lines.forEach(line => console.log(`line read: ${line}`))
+/// }
+/// ```
 class SplitParser: public DataStreamParser {
 	Q_OBJECT;
+	// clang-format off
 	/// The delimiter for parsed data. May be multiple characters. Defaults to `\n`.
 	///
 	/// If the delimiter is empty read lengths may be arbitrary (whatever is returned by the
-	/// underlying read call.)
+	/// underlying read call.) Combined with @@DataStreamParser.raw this passes binary
+	/// data through unmodified.
 	Q_PROPERTY(QString splitMarker READ splitMarker WRITE setSplitMarker NOTIFY splitMarkerChanged);
+	/// If true, delimited chunks are collected and emitted together via @@readBatch()
+	/// instead of one @@read() per chunk. Defaults to false.
+	///
+	/// Without a @@batchInterval, a batch is emitted once for each read from the underlying stream.
+	/// Batching is not available in @@DataStreamParser.raw mode.
+	Q_PROPERTY(bool batched READ batched WRITE setBatched NOTIFY batchedChanged);
+	/// The maximum number of chunks in a single batch. If a batch fills up it is emitted
+	/// immediately. Defaults to 0, which places no limit on batch size.
+	Q_PROPERTY(qint32 maxBatchSize READ maxBatchSize WRITE setMaxBatchSize NOTIFY maxBatchSizeChanged);
+	/// If greater than 0, batches are collected across reads and emitted at most once per
+	/// interval, in milliseconds. Defaults to 0.
+	///
+	/// Setting this to a frame time (e.g. `16`) lets a handler process everything read
+	/// during a frame at once.
+	Q_PROPERTY(qint32 batchInterval READ batchInterval WRITE setBatchInterval NOTIFY batchIntervalChanged);
+	// clang-format on
 	QML_ELEMENT;
 
 public:
-	explicit SplitParser(QObject* parent = nullptr): DataStreamParser(parent) {}
+	explicit SplitParser(QObject* parent = nullptr);
 
 	void parseBytes(QByteArray& incoming, QByteArray& buffer) override;
 
 	[[nodiscard]] QString splitMarker() const;
 	void setSplitMarker(QString marker);
 
+	[[nodiscard]] bool batched() const;
+	void setBatched(bool batched);
+
+	[[nodiscard]] qint32 maxBatchSize() const;
+	void setMaxBatchSize(qint32 maxBatchSize);
+
+	[[nodiscard]] qint32 batchInterval() const;
+	void setBatchInterval(qint32 batchInterval);
+
 signals:
+	/// Emitted with all chunks read since the last batch if @@batched is true.
+	void readBatch(QList<QString> data);
+
 	void splitMarkerChanged();
+	void batchedChanged();
+	void maxBatchSizeChanged();
+	void batchIntervalChanged();
+
+private slots:
+	void flushBatch();
 
 private:
+	void parseChunks(QByteArray& incoming, QByteArray& buffer);
+	void emitChunk(QByteArrayView chunk);
+
 	QString mSplitMarker = "\n";
+	QByteArray mSplitMarkerBytes = "\n";
 	bool mSplitMarkerChanged = false;
+	bool mBatched = false;
+	qint32 mMaxBatchSize = 0;
+	qint32 mBatchInterval = 0;
+	QList<QString> batch;
+	QTimer batchTimer;
+};
+
+///! Parser for newline delimited JSON.
+/// Parser for streams of newline delimited JSON documents (JSON lines), as produced by
+/// tools like `swaymsg -m -r` or most event streaming daemons.
+///
+/// Each line is decoded natively and emitted via @@readJson(), which is considerably
+/// cheaper than a @@SplitParser with a `JSON.parse` call in its handler.
+/// Lines must contain a JSON object or array. Blank lines are ignored, and lines that fail
+/// to parse are logged and skipped.
+/// ```qml
+/// JsonLineParser {
+///   onReadJson: event => console.log(`got event of type ${event.type}`)
+/// }
+/// ```
+class JsonLineParser: public DataStreamParser {
+	Q_OBJECT;
+	QML_ELEMENT;
+
+public:
+	explicit JsonLineParser(QObject* parent = nullptr): DataStreamParser(parent) {}
+
+	void parseBytes(QByteArray& incoming, QByteArray& buffer) override;
+
+signals:
+	/// Emitted with the decoded object or array for each line read from the stream.
+	void readJson(QVariant data);
+};
+
+///! Parser for length prefixed data streams.
+/// Parser for streams of length prefixed messages. Each message starts with a header
+/// of @@headerSize bytes containing its payload length, followed by the payload.
+///
+/// By default the payload is emitted as a string via @@read(), or as an `ArrayBuffer` via
+/// @@readBytes() in @@DataStreamParser.raw mode. If @@json is true it is decoded as
+/// a JSON object or array and emitted via @@readJson() instead.
+///
+/// #### Example
+/// Reading the responses and events of the sway IPC protocol, which uses a header
+/// consisting of the `i3-ipc` magic string, a 4 byte payload length and a 4 byte message type.
+/// ```qml
+/// LengthPrefixedParser {
+///   lengthOffset: 6
+///   headerSize: 14
+///   json: true
+///   onReadJson: message => console.log(JSON.stringify(message))
+/// }
+/// ```
+class LengthPrefixedParser: public DataStreamParser {
+	Q_OBJECT;
+	// clang-format off
+	/// The size of the length field in bytes. Must be 1, 2, 4 or 8. Defaults to 4.
+	Q_PROPERTY(qint32 lengthSize READ lengthSize WRITE setLengthSize NOTIFY lengthSizeChanged);
+	/// The offset of the length field from the start of the header in bytes. Defaults to 0.
+	Q_PROPERTY(qint32 lengthOffset READ lengthOffset WRITE setLengthOffset NOTIFY lengthOffsetChanged);
+	/// The total size of the header preceding the payload in bytes. Header bytes other than
+	/// the length field are skipped.
+	///
+	/// Defaults to 0, which uses @@lengthOffset + @@lengthSize.
+	Q_PROPERTY(qint32 headerSize READ headerSize WRITE setHeaderSize NOTIFY headerSizeChanged);
+	/// If the length field is big endian (network byte order). Defaults to false.
+	Q_PROPERTY(bool bigEndian READ bigEndian WRITE setBigEndian NOTIFY bigEndianChanged);
+	/// If the payload should be decoded as JSON and emitted via @@readJson(). Defaults to false.
+	Q_PROPERTY(bool json READ json WRITE setJson NOTIFY jsonChanged);
+	/// The largest payload length accepted, in bytes. Defaults to 16MiB.
+	///
+	/// A message announcing a longer payload is treated as a corrupt stream: a warning is logged
+	/// and all buffered data is discarded instead of waiting for the payload to arrive.
+	Q_PROPERTY(qint64 maxLength READ maxLength WRITE setMaxLength NOTIFY maxLengthChanged);
+	// clang-format on
+	QML_ELEMENT;
+
+public:
+	explicit LengthPrefixedParser(QObject* parent = nullptr): DataStreamParser(parent) {}
+
+	void parseBytes(QByteArray& incoming, QByteArray& buffer) override;
+
+	[[nodiscard]] qint32 lengthSize() const;
+	void setLengthSize(qint32 lengthSize);
+
+	[[nodiscard]] qint32 lengthOffset() const;
+	void setLengthOffset(qint32 lengthOffset);
+
+	[[nodiscard]] qint32 headerSize() const;
+	void setHeaderSize(qint32 headerSize);
+
+	[[nodiscard]] bool bigEndian() const;
+	void setBigEndian(bool bigEndian);
+
+	[[nodiscard]] bool json() const;
+	void setJson(bool json);
+
+	[[nodiscard]] qint64 maxLength() const;
+	void setMaxLength(qint64 maxLength);
+
+signals:
+	/// Emitted with the decoded payload of each message if @@json is true.
+	void readJson(QVariant data);
+
+	void lengthSizeChanged();
+	void lengthOffsetChanged();
+	void headerSizeChanged();
+	void bigEndianChanged();
+	void jsonChanged();
+	void maxLengthChanged();
+
+private:
+	[[nodiscard]] qsizetype effectiveHeaderSize() const;
+	[[nodiscard]] quint64 readLength(const char* header) const;
+	void emitPayload(QByteArrayView payload);
+
+	qint32 mLengthSize = 4;
+	qint32 mLengthOffset = 0;
+	qint32 mHeaderSize = 0;
+	bool mBigEndian = false;
+	bool mJson = false;
+	qint64 mMaxLength = qint64 {16} * 1024 * 1024;
 };
@@ -4,7 +4,10 @@
 namespace {
 
 class IoPlugin: public QuickshellPlugin {
-	void onReload() override { DisownedProcessContext::destroyInstance(); }
+	void onReload() override {
+		DisownedProcessContext::destroyInstance();
+		Process::clearEnvironmentCache();
+	}
 };
 
 QS_REGISTER_PLUGIN(IoPlugin);
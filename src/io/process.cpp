@@ -1,13 +1,18 @@
 #include "process.hpp"
+#include <algorithm>
 #include <csignal> // NOLINT
+#include <optional>
 #include <utility>
 
 #include <qdir.h>
+#include <qelapsedtimer.h>
 #include <qlist.h>
 #include <qlogging.h>
+#include <qmetatype.h>
 #include <qmap.h>
 #include <qobject.h>
 #include <qprocess.h>
+#include <qtimer.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 #include <qvariant.h>
@@ -19,6 +24,31 @@
 // meaning the destructor never runs and they are never killed.
 static DisownedProcessContext* disownedCtx; // NOLINT
 
+// Building the system environment copies and parses environ, which adds up when
+// processes are started every few seconds. It is cached until the next reload.
+static std::optional<QProcessEnvironment> systemEnvironmentCache; // NOLINT
+
+// delay before restarting a persistent process, to avoid spinning on a crashing command.
+// It doubles for every run shorter than PERSISTENT_STABLE_TIME (or failed start), up to the max.
+constexpr qint32 PERSISTENT_RESTART_DELAY = 1000;
+constexpr qint32 PERSISTENT_MAX_RESTART_DELAY = 60000;
+constexpr qint32 PERSISTENT_MAX_BACKOFF_STEPS = 6;
+constexpr qint64 PERSISTENT_STABLE_TIME = 10000;
+// most data queued by writes made while a persistent process is (re)starting
+constexpr qsizetype MAX_PENDING_WRITE = qsizetype {1024} * 1024;
+
+namespace {
+
+const QProcessEnvironment& systemEnvironment() {
+	if (!systemEnvironmentCache.has_value()) {
+		systemEnvironmentCache = QProcessEnvironment::systemEnvironment();
+	}
+
+	return *systemEnvironmentCache;
+}
+
+} // namespace
+
 Process::Process(QObject* parent): QObject(parent) {
 	QObject::connect(
 	    QuickshellSettings::instance(),
@@ -26,6 +56,9 @@ Process::Process(QObject* parent): QObject(parent) {
 	    this,
 	    &Process::onGlobalWorkingDirectoryChanged
 	);
+
+	this->restartTimer.setSingleShot(true);
+	QObject::connect(&this->restartTimer, &QTimer::timeout, this, &Process::onRestartTimeout);
 }
 
 Process::~Process() {
@@ -39,8 +72,16 @@ bool Process::isRunning() const { return this->process != nullptr; }
 
 void Process::setRunning(bool running) {
 	this->targetRunning = running;
-	if (running) this->startProcessIfReady();
-	else if (this->isRunning()) this->process->terminate();
+	this->stopRequested = !running;
+	this->restartTimer.stop();
+
+	if (running) {
+		this->restartBackoff = 0;
+		this->startProcessIfReady();
+	} else {
+		this->pendingWrite.clear();
+		if (this->isRunning()) this->process->terminate();
+	}
 }
 
 QVariant Process::processId() const {
@@ -180,6 +221,47 @@ void Process::setLifetimeManaged(bool managed) {
 	emit this->lifetimeManagedChanged();
 }
 
+bool Process::isPersistent() const { return this->mPersistent; }
+
+void Process::setPersistent(bool persistent) {
+	if (persistent == this->mPersistent) return;
+	this->mPersistent = persistent;
+
+	if (!persistent && this->restartTimer.isActive()) {
+		this->restartTimer.stop();
+		this->pendingWrite.clear();
+	}
+
+	emit this->persistentChanged();
+}
+
+void Process::clearEnvironmentCache() { systemEnvironmentCache.reset(); }
+
+void Process::scheduleRestart() {
+	// a handler of the exit may have already started the process again
+	if (this->process != nullptr) return;
+
+	if (!this->mPersistent || this->stopRequested) {
+		this->pendingWrite.clear();
+		return;
+	}
+
+	auto stable = this->runTimer.isValid() && this->runTimer.elapsed() >= PERSISTENT_STABLE_TIME;
+	if (stable) this->restartBackoff = 0;
+
+	auto delay = PERSISTENT_RESTART_DELAY << this->restartBackoff;
+	this->restartTimer.start(std::min(delay, PERSISTENT_MAX_RESTART_DELAY));
+
+	if (this->restartBackoff < PERSISTENT_MAX_BACKOFF_STEPS) this->restartBackoff++;
+}
+
+void Process::onRestartTimeout() {
+	// the process may have been restarted or stopped while the timer was pending
+	if (!this->mPersistent || this->stopRequested || this->process != nullptr) return;
+	this->targetRunning = true;
+	this->startProcessIfReady();
+}
+
 void Process::startProcessIfReady() {
 	if (this->process != nullptr || !this->targetRunning || this->mCommand.isEmpty()) return;
 	this->targetRunning = false;
@@ -188,6 +270,7 @@ void Process::startProcessIfReady() {
 	auto args = this->mCommand.sliced(1);
 
 	this->process = new QProcess(this);
+	this->runTimer.invalidate();
 
 	// clang-format off
 	QObject::connect(this->process, &QProcess::started, this, &Process::onStarted);
@@ -209,7 +292,7 @@ void Process::startProcessIfReady() {
 	}
 
 	if (!this->mEnvironment.isEmpty() || this->mClearEnvironment) {
-		auto sysenv = QProcessEnvironment::systemEnvironment();
+		const auto& sysenv = systemEnvironment();
 		auto env = this->mClearEnvironment ? QProcessEnvironment() : sysenv;
 
 		for (auto& name: this->mEnvironment.keys()) {
@@ -233,6 +316,13 @@ void Process::startProcessIfReady() {
 }
 
 void Process::onStarted() {
+	this->runTimer.start();
+
+	if (!this->pendingWrite.isEmpty()) {
+		if (this->mStdinEnabled) this->process->write(this->pendingWrite);
+		this->pendingWrite.clear();
+	}
+
 	emit this->processIdChanged();
 	emit this->runningChanged();
 	emit this->started();
@@ -247,6 +337,8 @@ void Process::onFinished(qint32 exitCode, QProcess::ExitStatus exitStatus) {
 	emit this->exited(exitCode, exitStatus);
 	emit this->runningChanged();
 	emit this->processIdChanged();
+
+	this->scheduleRestart();
 }
 
 void Process::onErrorOccurred(QProcess::ProcessError error) {
@@ -256,6 +348,8 @@ void Process::onErrorOccurred(QProcess::ProcessError error) {
 		this->process->deleteLater();
 		this->process = nullptr;
 		emit this->runningChanged();
+
+		this->scheduleRestart();
 	}
 }
 
@@ -276,9 +370,24 @@ void Process::signal(qint32 signal) {
 	kill(static_cast<qint32>(this->process->processId()), signal); // NOLINT
 }
 
-void Process::write(const QString& data) {
-	if (this->process == nullptr) return;
-	this->process->write(data.toUtf8());
+void Process::write(const QVariant& data) {
+	// writes made before a persistent process has (re)started are queued
+	auto starting = this->process == nullptr ? this->restartTimer.isActive()
+	                                         : this->process->state() != QProcess::Running;
+
+	if (this->process == nullptr && !starting) return;
+
+	auto bytes = data.typeId() == QMetaType::QByteArray ? data.toByteArray()
+	                                                    : data.toString().toUtf8();
+
+	if (!starting) {
+		this->process->write(bytes);
+	} else if (this->pendingWrite.size() + bytes.size() > MAX_PENDING_WRITE) {
+		qWarning() << "Dropping write to" << this << "as more than" << MAX_PENDING_WRITE
+		           << "bytes are already queued while it starts.";
+	} else {
+		this->pendingWrite.append(bytes);
+	}
 }
 
 void DisownedProcessContext::reparent(QProcess* process) {
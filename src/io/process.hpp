@@ -1,10 +1,12 @@
 #pragma once
 
 #include <qcontainerfwd.h>
+#include <qelapsedtimer.h>
 #include <qobject.h>
 #include <qprocess.h>
 #include <qqmlintegration.h>
 #include <qtclasshelpermacros.h>
+#include <qtimer.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 #include <qvariant.h>
@@ -22,6 +24,30 @@
 ///   }
 /// }
 /// ```
+///
+/// #### Persistent processes
+/// Spawning a process is comparatively expensive. If a command needs to be queried often,
+/// a long lived worker that reads requests from stdin and answers on stdout can be
+/// kept running with @@persistent.
+/// ```qml
+/// Process {
+///   id: worker
+///   running: true
+///   persistent: true
+///   stdinEnabled: true
+///   command: [ "some-daemon", "--serve" ]
+///   stdout: JsonLineParser {
+///     onReadJson: reply => console.log(`got reply: ${reply.value}`)
+///   }
+/// }
+///
+/// Timer {
+///   running: true
+///   repeat: true
+///   interval: 1000
+///   onTriggered: worker.write("query\n")
+/// }
+/// ```
 class Process: public QObject {
 	Q_OBJECT;
 	// clang-format off
@@ -105,6 +131,8 @@ class Process: public QObject {
 	Q_PROPERTY(bool clearEnvironment READ environmentCleared WRITE setEnvironmentCleared NOTIFY environmentClearChanged);
 	/// The parser for stdout. If the parser is null the process's stdout channel will be closed
 	/// and no further data will be read, even if a new parser is attached.
+	///
+	/// To read binary output, set @@DataStreamParser.raw on the parser.
 	Q_PROPERTY(DataStreamParser* stdout READ stdoutParser WRITE setStdoutParser NOTIFY stdoutParserChanged);
 	/// The parser for stderr. If the parser is null the process's stdout channel will be closed
 	/// and no further data will be read, even if a new parser is attached.
@@ -120,6 +148,15 @@ class Process: public QObject {
 	/// > [!WARNING] If set to false the process will still be killed if the quickshell config reloads.
 	/// > It will not be killed if quickshell exits normally or crashes.
 	Q_PROPERTY(bool manageLifetime READ isLifetimeManaged WRITE setLifetimeManaged NOTIFY lifetimeManagedChanged);
+	/// If the process should be restarted when it exits. Defaults to false.
+	///
+	/// A persistent process is restarted after a short delay whenever it exits, until @@running
+	/// is set to false. If it keeps exiting or failing to start shortly after being started, the
+	/// delay doubles with each attempt, up to a minute.
+	///
+	/// Data passed to @@write() while the process is starting or restarting is queued
+	/// and written once it has started.
+	Q_PROPERTY(bool persistent READ isPersistent WRITE setPersistent NOTIFY persistentChanged);
 	// clang-format on
 	QML_ELEMENT;
 
@@ -132,7 +169,14 @@ public:
 	Q_INVOKABLE void signal(qint32 signal);
 
 	/// Writes to the process's stdin. Does nothing if @@running is false.
-	Q_INVOKABLE void write(const QString& data);
+	///
+	/// Writes made while the process is starting, or while a @@persistent process is waiting
+	/// to be restarted, are queued and sent once it has started, up to 1MiB. Queued writes
+	/// are discarded if @@running is set to false.
+	///
+	/// Strings are written as UTF-8, and `ArrayBuffer`s are written as is,
+	/// which allows binary data to be sent to the process.
+	Q_INVOKABLE void write(const QVariant& data);
 
 	[[nodiscard]] bool isRunning() const;
 	void setRunning(bool running);
@@ -163,6 +207,12 @@ public:
 	[[nodiscard]] bool isLifetimeManaged() const;
 	void setLifetimeManaged(bool managed);
 
+	[[nodiscard]] bool isPersistent() const;
+	void setPersistent(bool persistent);
+
+	// drops the cached system environment so changes are picked up by the next process
+	static void clearEnvironmentCache();
+
 signals:
 	void started();
 	void exited(qint32 exitCode, QProcess::ExitStatus exitStatus);
@@ -177,6 +227,7 @@ signals:
 	void stderrParserChanged();
 	void stdinEnabledChanged();
 	void lifetimeManagedChanged();
+	void persistentChanged();
 
 private slots:
 	void onStarted();
@@ -187,9 +238,11 @@ private slots:
 	void onStdoutParserDestroyed();
 	void onStderrParserDestroyed();
 	void onGlobalWorkingDirectoryChanged();
+	void onRestartTimeout();
 
 private:
 	void startProcessIfReady();
+	void scheduleRestart();
 
 	QProcess* process = nullptr;
 	QList<QString> mCommand;
@@ -199,8 +252,14 @@ private:
 	DataStreamParser* mStderrParser = nullptr;
 	QByteArray stdoutBuffer;
 	QByteArray stderrBuffer;
+	QByteArray pendingWrite;
+	QTimer restartTimer;
+	QElapsedTimer runTimer;
+	qint32 restartBackoff = 0;
 
 	bool targetRunning = false;
+	bool stopRequested = false;
+	bool mPersistent = false;
 	bool mStdinEnabled = false;
 	bool mClearEnvironment = false;
 	bool mLifetimeManaged = true;
@@ -3,14 +3,18 @@
 #include <qbytearray.h>
 #include <qlist.h>
 #include <qlogging.h>
+#include <qnamespace.h>
 #include <qobject.h>
+#include <qregularexpression.h>
 #include <qsignalspy.h>
 #include <qtest.h>
 #include <qtestcase.h>
+#include <qtypes.h>
+#include <qvariant.h>
 
 #include "../datastream.hpp"
 
-void TestSplitParser::splits_data() { // NOLINT
+void TestDataStreamParser::splits_data() { // NOLINT
 	QTest::addColumn<QString>("mark");
 	QTest::addColumn<QString>("buffer");   // max that can go in the buffer
 	QTest::addColumn<QString>("incoming"); // data that has to be tested on the end in one go
@@ -38,11 +42,15 @@ void TestSplitParser::splits_data() { // NOLINT
 	QTest::addRow("longsplit-incomplete") << "123"
 		<< "foo12" << "3bar123baz"
 		<< QList<QString>({ "foo", "bar" }) << "baz";
+
+	QTest::addRow("overlapping-marker") << "aab"
+		<< "fooaaa" << "abbar"
+		<< QList<QString>("fooaa") << "bar";
 	// clang-format on
 	// NOLINTEND
 }
 
-void TestSplitParser::splits() { // NOLINT
+void TestDataStreamParser::splits() { // NOLINT
 	// NOLINTBEGIN
 	QFETCH(QString, mark);
 	QFETCH(QString, buffer);
@@ -82,7 +90,7 @@ void TestSplitParser::splits() { // NOLINT
 	}
 }
 
-void TestSplitParser::initBuffer() { // NOLINT
+void TestDataStreamParser::initBuffer() { // NOLINT
 	auto parser = SplitParser();
 	auto spy = QSignalSpy(&parser, &DataStreamParser::read);
 
@@ -103,4 +111,252 @@ void TestSplitParser::initBuffer() { // NOLINT
 	QCOMPARE(buf, "baz");
 }
 
-QTEST_MAIN(TestSplitParser);
+void TestDataStreamParser::batch() { // NOLINT
+	auto parser = SplitParser();
+	auto readSpy = QSignalSpy(&parser, &DataStreamParser::read);
+	auto batchSpy = QSignalSpy(&parser, &SplitParser::readBatch);
+
+	parser.setSplitMarker("-");
+	parser.setBatched(true);
+	parser.setMaxBatchSize(2);
+
+	auto buffer = QByteArray();
+	auto incoming = QString("foo-bar-baz-qux").toUtf8();
+	parser.parseBytes(incoming, buffer);
+
+	QCOMPARE(readSpy.length(), 0);
+	QCOMPARE(batchSpy.length(), 2);
+	QCOMPARE(batchSpy[0][0].value<QList<QString>>(), QList<QString>({"foo", "bar"}));
+	QCOMPARE(batchSpy[1][0].value<QList<QString>>(), QList<QString>({"baz"}));
+	QCOMPARE(buffer, "qux");
+}
+
+void TestDataStreamParser::raw() { // NOLINT
+	auto parser = SplitParser();
+	auto readSpy = QSignalSpy(&parser, &DataStreamParser::read);
+	auto bytesSpy = QSignalSpy(&parser, &DataStreamParser::readBytes);
+
+	parser.setRaw(true);
+
+	auto buffer = QByteArray();
+	auto incoming = QByteArray("\xff\x00\xfe\n\x00\x01", 6);
+	parser.parseBytes(incoming, buffer);
+
+	QCOMPARE(readSpy.length(), 0);
+	QCOMPARE(bytesSpy.length(), 1);
+	QCOMPARE(bytesSpy[0][0].toByteArray(), QByteArray("\xff\x00\xfe", 3));
+	QCOMPARE(buffer, QByteArray("\x00\x01", 2));
+}
+
+void TestDataStreamParser::jsonLines_data() { // NOLINT
+	QTest::addColumn<QList<QByteArray>>("reads");
+	QTest::addColumn<QVariantList>("results");
+	QTest::addColumn<QByteArray>("remainder");
+	QTest::addColumn<bool>("invalid");
+
+	auto object = QVariant(QVariantMap({{"foo", "bar"}}));
+	auto array = QVariant(QVariantList({"baz"}));
+
+	// NOLINTBEGIN
+	// clang-format off
+	QTest::addRow("simple")
+		<< QList<QByteArray>({"{\"foo\":\"bar\"}\n"})
+		<< QVariantList({object}) << QByteArray() << false;
+
+	QTest::addRow("multiple")
+		<< QList<QByteArray>({"{\"foo\":\"bar\"}\n[\"baz\"]\n"})
+		<< QVariantList({object, array}) << QByteArray() << false;
+
+	QTest::addRow("split-line")
+		<< QList<QByteArray>({"{\"fo", "o\":", "\"bar\"}\n[\"b"})
+		<< QVariantList({object}) << QByteArray("[\"b") << false;
+
+	QTest::addRow("split-newline")
+		<< QList<QByteArray>({"[\"baz\"]", "\n"})
+		<< QVariantList({array}) << QByteArray() << false;
+
+	QTest::addRow("blank-lines")
+		<< QList<QByteArray>({"\n  \n[\"baz\"]\n\n"})
+		<< QVariantList({array}) << QByteArray() << false;
+
+	QTest::addRow("invalid")
+		<< QList<QByteArray>({"{foo\n[\"baz\"]\n"})
+		<< QVariantList({array}) << QByteArray() << true;
+	// clang-format on
+	// NOLINTEND
+}
+
+void TestDataStreamParser::jsonLines() { // NOLINT
+	// NOLINTBEGIN
+	QFETCH(QList<QByteArray>, reads);
+	QFETCH(QVariantList, results);
+	QFETCH(QByteArray, remainder);
+	QFETCH(bool, invalid);
+	// NOLINTEND
+
+	if (invalid) {
+		QTest::ignoreMessage(QtWarningMsg, QRegularExpression("^Failed to parse JSON"));
+	}
+
+	auto parser = JsonLineParser();
+	auto spy = QSignalSpy(&parser, &JsonLineParser::readJson);
+
+	auto buffer = QByteArray();
+	for (auto read: reads) {
+		parser.parseBytes(read, buffer);
+	}
+
+	auto actualResults = QVariantList();
+	for (auto& read: spy) {
+		actualResults.push_back(read[0]);
+	}
+
+	QCOMPARE(actualResults, results);
+	QCOMPARE(buffer, remainder);
+}
+
+void TestDataStreamParser::lengthPrefixed_data() { // NOLINT
+	QTest::addColumn<qint32>("lengthSize");
+	QTest::addColumn<qint32>("lengthOffset");
+	QTest::addColumn<qint32>("headerSize");
+	QTest::addColumn<bool>("bigEndian");
+	QTest::addColumn<QList<QByteArray>>("reads");
+	QTest::addColumn<QList<QByteArray>>("results");
+	QTest::addColumn<QByteArray>("remainder");
+
+	auto hex = [](const char* data) { return QByteArray::fromHex(data); };
+
+	// NOLINTBEGIN
+	// clang-format off
+	QTest::addRow("u8") << 1 << 0 << 0 << false
+		<< QList<QByteArray>({hex("03") + "foo"})
+		<< QList<QByteArray>({"foo"}) << QByteArray();
+
+	QTest::addRow("u16-le") << 2 << 0 << 0 << false
+		<< QList<QByteArray>({hex("0300") + "foo"})
+		<< QList<QByteArray>({"foo"}) << QByteArray();
+
+	QTest::addRow("u16-be") << 2 << 0 << 0 << true
+		<< QList<QByteArray>({hex("0003") + "foo"})
+		<< QList<QByteArray>({"foo"}) << QByteArray();
+
+	QTest::addRow("u32-le") << 4 << 0 << 0 << false
+		<< QList<QByteArray>({hex("03000000") + "foo"})
+		<< QList<QByteArray>({"foo"}) << QByteArray();
+
+	QTest::addRow("u32-be") << 4 << 0 << 0 << true
+		<< QList<QByteArray>({hex("00000003") + "foo"})
+		<< QList<QByteArray>({"foo"}) << QByteArray();
+
+	QTest::addRow("u64-le") << 8 << 0 << 0 << false
+		<< QList<QByteArray>({hex("0300000000000000") + "foo"})
+		<< QList<QByteArray>({"foo"}) << QByteArray();
+
+	QTest::addRow("u64-be") << 8 << 0 << 0 << true
+		<< QList<QByteArray>({hex("0000000000000003") + "foo"})
+		<< QList<QByteArray>({"foo"}) << QByteArray();
+
+	QTest::addRow("empty-payload") << 1 << 0 << 0 << false
+		<< QList<QByteArray>({hex("00") + hex("01") + "a"})
+		<< QList<QByteArray>({"", "a"}) << QByteArray();
+
+	QTest::addRow("multiple") << 1 << 0 << 0 << false
+		<< QList<QByteArray>({hex("03") + "foo" + hex("02") + "ba" + hex("01") + "z"})
+		<< QList<QByteArray>({"foo", "ba", "z"}) << QByteArray();
+
+	QTest::addRow("partial-header") << 4 << 0 << 0 << false
+		<< QList<QByteArray>({hex("03") + "foo" + hex("0300")})
+		<< QList<QByteArray>() << hex("03") + "foo" + hex("0300");
+
+	QTest::addRow("split-header") << 4 << 0 << 0 << false
+		<< QList<QByteArray>({hex("0300"), hex("0000") + "fo", "o"})
+		<< QList<QByteArray>({"foo"}) << QByteArray();
+
+	QTest::addRow("partial-payload") << 2 << 0 << 0 << false
+		<< QList<QByteArray>({hex("0100") + "a" + hex("0300") + "fo"})
+		<< QList<QByteArray>({"a"}) << hex("0300") + "fo";
+
+	// sway ipc style header: magic, length, message type
+	QTest::addRow("padded-header") << 4 << 6 << 14 << false
+		<< QList<QByteArray>({"i3-ipc" + hex("03000000") + hex("01000000") + "foo"})
+		<< QList<QByteArray>({"foo"}) << QByteArray();
+
+	QTest::addRow("padded-header-split") << 4 << 6 << 14 << false
+		<< QList<QByteArray>({"i3-ipc" + hex("0300"), hex("0000") + hex("0100"), hex("0000") + "foo"})
+		<< QList<QByteArray>({"foo"}) << QByteArray();
+
+	QTest::addRow("header-smaller-than-field") << 2 << 2 << 1 << false
+		<< QList<QByteArray>({"xx" + hex("0300") + "foo"})
+		<< QList<QByteArray>({"foo"}) << QByteArray();
+	// clang-format on
+	// NOLINTEND
+}
+
+void TestDataStreamParser::lengthPrefixed() { // NOLINT
+	// NOLINTBEGIN
+	QFETCH(qint32, lengthSize);
+	QFETCH(qint32, lengthOffset);
+	QFETCH(qint32, headerSize);
+	QFETCH(bool, bigEndian);
+	QFETCH(QList<QByteArray>, reads);
+	QFETCH(QList<QByteArray>, results);
+	QFETCH(QByteArray, remainder);
+	// NOLINTEND
+
+	auto parser = LengthPrefixedParser();
+	auto spy = QSignalSpy(&parser, &DataStreamParser::readBytes);
+
+	parser.setRaw(true);
+	parser.setLengthSize(lengthSize);
+	parser.setLengthOffset(lengthOffset);
+	parser.setHeaderSize(headerSize);
+	parser.setBigEndian(bigEndian);
+
+	auto buffer = QByteArray();
+	for (auto read: reads) {
+		parser.parseBytes(read, buffer);
+	}
+
+	auto actualResults = QList<QByteArray>();
+	for (auto& read: spy) {
+		actualResults.push_back(read[0].toByteArray());
+	}
+
+	QCOMPARE(actualResults, results);
+	QCOMPARE(buffer, remainder);
+}
+
+void TestDataStreamParser::lengthPrefixedOverflow() { // NOLINT
+	auto parser = LengthPrefixedParser();
+	auto spy = QSignalSpy(&parser, &DataStreamParser::readBytes);
+
+	parser.setRaw(true);
+
+	QTest::ignoreMessage(QtWarningMsg, QRegularExpression("exceeds maxLength"));
+
+	auto buffer = QByteArray();
+	auto incoming = QByteArray::fromHex("01000000") + "a" + QByteArray::fromHex("ffffffff") + "foo";
+	parser.parseBytes(incoming, buffer);
+
+	QCOMPARE(spy.length(), 1);
+	QCOMPARE(spy[0][0].toByteArray(), "a");
+	QCOMPARE(buffer, QByteArray());
+
+	// the parser keeps working once the stream is back in sync
+	incoming = QByteArray::fromHex("03000000") + "foo";
+	parser.parseBytes(incoming, buffer);
+
+	QCOMPARE(spy.length(), 2);
+	QCOMPARE(spy[1][0].toByteArray(), "foo");
+
+	parser.setMaxLength(2);
+	QTest::ignoreMessage(QtWarningMsg, QRegularExpression("exceeds maxLength"));
+
+	incoming = QByteArray::fromHex("03000000");
+	parser.parseBytes(incoming, buffer);
+
+	QCOMPARE(spy.length(), 2);
+	QCOMPARE(buffer, QByteArray());
+}
+
+QTEST_MAIN(TestDataStreamParser);
@@ -3,11 +3,18 @@
 #include <qobject.h>
 #include <qtmetamacros.h>
 
-class TestSplitParser: public QObject {
+class TestDataStreamParser: public QObject {
 	Q_OBJECT;
 
 private slots:
 	void splits_data(); // NOLINT
 	void splits();
 	void initBuffer();
+	void batch();
+	void raw();
+	void jsonLines_data(); // NOLINT
+	void jsonLines();
+	void lengthPrefixed_data(); // NOLINT
+	void lengthPrefixed();
+	void lengthPrefixedOverflow();
 };
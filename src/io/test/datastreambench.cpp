@@ -0,0 +1,63 @@
+#include "datastreambench.hpp"
+#include <algorithm>
+
+#include <qbytearray.h>
+#include <qlist.h>
+#include <qobject.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qtypes.h>
+
+#include "../datastream.hpp"
+
+void BenchSplitParser::split_data() { // NOLINT
+	QTest::addColumn<QString>("mark");
+	QTest::addColumn<qsizetype>("lineLength");
+	QTest::addColumn<qsizetype>("chunkSize");
+
+	// NOLINTBEGIN
+	// clang-format off
+	QTest::addRow("short-lines") << "\n" << qsizetype(16) << qsizetype(4096);
+	QTest::addRow("long-lines") << "\n" << qsizetype(4096) << qsizetype(65536);
+	QTest::addRow("multibyte-marker") << "\r\n" << qsizetype(80) << qsizetype(4096);
+	QTest::addRow("small-chunks") << "\n" << qsizetype(80) << qsizetype(7);
+	// clang-format on
+	// NOLINTEND
+}
+
+void BenchSplitParser::split() {
+	// NOLINTBEGIN
+	QFETCH(QString, mark);
+	QFETCH(qsizetype, lineLength);
+	QFETCH(qsizetype, chunkSize);
+	// NOLINTEND
+
+	auto line = QByteArray(lineLength, 'x');
+	line.append(mark.toUtf8());
+
+	auto stream = line.repeated((4 * 1024 * 1024) / line.length());
+
+	auto chunks = QList<QByteArray>();
+	for (qsizetype i = 0; i < stream.length(); i += chunkSize) {
+		chunks.push_back(stream.sliced(i, std::min(chunkSize, stream.length() - i)));
+	}
+
+	qsizetype reads = 0;
+	auto parser = SplitParser();
+	parser.setSplitMarker(mark);
+	QObject::connect(&parser, &DataStreamParser::read, &parser, [&]() { reads++; });
+
+	QBENCHMARK {
+		reads = 0;
+		auto buffer = QByteArray();
+
+		for (const auto& chunk: chunks) {
+			auto incoming = chunk;
+			parser.parseBytes(incoming, buffer);
+		}
+	}
+
+	QCOMPARE(reads, stream.length() / line.length());
+}
+
+QTEST_MAIN(BenchSplitParser);
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <qobject.h>
+#include <qtmetamacros.h>
+
+class BenchSplitParser: public QObject {
+	Q_OBJECT;
+
+private slots:
+	static void split_data(); // NOLINT
+	static void split();
+};
@@ -0,0 +1,404 @@
+#include "artcache.hpp"
+#include <algorithm>
+#include <vector>
+
+#include <qcolor.h>
+#include <qcontainerfwd.h>
+#include <qcryptographichash.h>
+#include <qdatetime.h>
+#include <qdir.h>
+#include <qfile.h>
+#include <qfileinfo.h>
+#include <qimage.h>
+#include <qimagereader.h>
+#include <qlogging.h>
+#include <qloggingcategory.h>
+#include <qmutex.h>
+#include <qnamespace.h>
+#include <qnetworkreply.h>
+#include <qnetworkrequest.h>
+#include <qobject.h>
+#include <qquickimageprovider.h>
+#include <qsavefile.h>
+#include <qsize.h>
+#include <qthreadpool.h>
+#include <qtypes.h>
+#include <qurl.h>
+
+#include "../../core/paths.hpp"
+
+namespace qs::service::mpris {
+
+Q_LOGGING_CATEGORY(logMprisArt, "quickshell.service.mp.art", QtWarningMsg);
+
+namespace {
+
+constexpr qsizetype MEMORY_CACHE_KIB = 32 * 1024;
+constexpr qint64 DISK_CACHE_BYTES = qint64 {64} * 1024 * 1024;
+constexpr qint64 MAX_DOWNLOAD_BYTES = qint64 {16} * 1024 * 1024;
+
+constexpr qint32 PALETTE_SAMPLE_SIZE = 64;
+constexpr qsizetype PALETTE_SIZE = 5;
+constexpr qsizetype PALETTE_CACHE_SIZE = 32;
+// squared rgb distance two palette colors must be apart
+constexpr qint32 PALETTE_MIN_DISTANCE = 48 * 48;
+
+QImage decodeArt(const QString& path, const QSize& requestedSize) {
+	auto reader = QImageReader(path);
+	reader.setAutoTransform(true);
+
+	auto size = reader.size();
+	if (size.isValid() && (requestedSize.width() > 0 || requestedSize.height() > 0)) {
+		auto bounds = QSize(
+		    requestedSize.width() > 0 ? requestedSize.width() : size.width(),
+		    requestedSize.height() > 0 ? requestedSize.height() : size.height()
+		);
+
+		// only ever scale down, the full size image is already as sharp as it gets
+		auto scaled = size.scaled(bounds, Qt::KeepAspectRatio);
+		if (scaled.width() < size.width()) reader.setScaledSize(scaled);
+	}
+
+	auto image = reader.read();
+
+	if (image.isNull()) {
+		qCWarning(logMprisArt) << "Could not decode album art" << path << reader.errorString();
+	}
+
+	return image;
+}
+
+QVector<QColor> extractPalette(const QImage& source) {
+	if (source.isNull()) return {};
+
+	auto image = source.convertToFormat(QImage::Format_ARGB32);
+
+	struct Bucket {
+		qint64 red = 0;
+		qint64 green = 0;
+		qint64 blue = 0;
+		qint32 count = 0;
+	};
+
+	// 4 bits per channel
+	auto buckets = std::vector<Bucket>(4096);
+
+	for (auto y = 0; y != image.height(); y++) {
+		const auto* line = reinterpret_cast<const QRgb*>(image.constScanLine(y)); // NOLINT
+
+		for (auto x = 0; x != image.width(); x++) {
+			auto pixel = line[x]; // NOLINT
+			if (qAlpha(pixel) < 128) continue;
+
+			auto index = ((qRed(pixel) >> 4) << 8) | ((qGreen(pixel) >> 4) << 4) | (qBlue(pixel) >> 4);
+			auto& bucket = buckets[index];
+			bucket.red += qRed(pixel);
+			bucket.green += qGreen(pixel);
+			bucket.blue += qBlue(pixel);
+			bucket.count++;
+		}
+	}
+
+	auto order = std::vector<qsizetype>();
+	for (size_t i = 0; i != buckets.size(); i++) {
+		if (buckets[i].count != 0) order.push_back(static_cast<qsizetype>(i));
+	}
+
+	std::ranges::sort(order, [&](qsizetype a, qsizetype b) {
+		return buckets[a].count > buckets[b].count;
+	});
+
+	auto palette = QVector<QColor>();
+
+	for (auto index: order) {
+		const auto& bucket = buckets[index];
+		auto color = QColor(
+		    static_cast<qint32>(bucket.red / bucket.count),
+		    static_cast<qint32>(bucket.green / bucket.count),
+		    static_cast<qint32>(bucket.blue / bucket.count)
+		);
+
+		auto distinct = std::ranges::all_of(palette, [&](const QColor& other) {
+			auto dr = color.red() - other.red();
+			auto dg = color.green() - other.green();
+			auto db = color.blue() - other.blue();
+			return dr * dr + dg * dg + db * db >= PALETTE_MIN_DISTANCE;
+		});
+
+		if (!distinct) continue;
+
+		palette.push_back(color);
+		if (palette.length() == PALETTE_SIZE) break;
+	}
+
+	return palette;
+}
+
+} // namespace
+
+MprisArtCache::MprisArtCache() {
+	this->images.setMaxCost(MEMORY_CACHE_KIB);
+	this->palettes.setMaxCost(PALETTE_CACHE_SIZE);
+
+	if (auto* cacheDir = QsPaths::instance()->cacheDir()) {
+		this->dir = QDir(cacheDir->filePath("mpris-art"));
+		this->hasDir = this->dir.mkpath(".");
+	}
+
+	if (!this->hasDir) {
+		qCWarning(logMprisArt) << "No cache directory. Remote album art will not be loaded.";
+	}
+}
+
+MprisArtCache* MprisArtCache::instance() {
+	static auto* instance = new MprisArtCache(); // NOLINT
+	return instance;
+}
+
+QString MprisArtCache::providerUrl(const QString& artUrl) {
+	if (artUrl.isEmpty()) return "";
+	return "image://mprisart/" + QString::fromUtf8(QUrl::toPercentEncoding(artUrl));
+}
+
+QString MprisArtCache::imageKey(const QUrl& url, const QSize& size) {
+	return url.toString() + '@' + QString::number(size.width()) + 'x'
+	     + QString::number(size.height());
+}
+
+QImage MprisArtCache::cachedImage(const QString& key) {
+	auto locker = QMutexLocker(&this->mutex);
+	auto* image = this->images.object(key);
+	return image ? *image : QImage();
+}
+
+void MprisArtCache::requestImage(const QString& key, const QUrl& url, QSize size) {
+	if (auto image = this->cachedImage(key); !image.isNull()) {
+		emit this->imageReady(key, image);
+		return;
+	}
+
+	if (this->decoding.contains(key)) return;
+	this->decoding.insert(key);
+
+	this->resolve(url, [this, key, size](const QString& path) {
+		if (path.isEmpty()) {
+			this->onDecoded(key, QImage());
+			return;
+		}
+
+		QThreadPool::globalInstance()->start([this, key, path, size]() {
+			auto image = decodeArt(path, size);
+
+			QMetaObject::invokeMethod(
+			    this,
+			    [this, key, image]() { this->onDecoded(key, image); },
+			    Qt::QueuedConnection
+			);
+		});
+	});
+}
+
+void MprisArtCache::onDecoded(const QString& key, const QImage& image) {
+	this->decoding.remove(key);
+
+	if (!image.isNull()) {
+		auto locker = QMutexLocker(&this->mutex);
+		auto cost = std::max<qsizetype>(image.sizeInBytes() / 1024, 1);
+		this->images.insert(key, new QImage(image), cost);
+	}
+
+	emit this->imageReady(key, image);
+}
+
+void MprisArtCache::requestPalette(const QUrl& url) {
+	if (auto* palette = this->palettes.object(url)) {
+		emit this->paletteReady(url, *palette);
+		return;
+	}
+
+	if (this->extracting.contains(url)) return;
+	this->extracting.insert(url);
+
+	this->resolve(url, [this, url](const QString& path) {
+		if (path.isEmpty()) {
+			this->onPaletteExtracted(url, {});
+			return;
+		}
+
+		QThreadPool::globalInstance()->start([this, url, path]() {
+			auto image = decodeArt(path, QSize(PALETTE_SAMPLE_SIZE, PALETTE_SAMPLE_SIZE));
+			auto palette = extractPalette(image);
+
+			QMetaObject::invokeMethod(
+			    this,
+			    [this, url, palette]() { this->onPaletteExtracted(url, palette); },
+			    Qt::QueuedConnection
+			);
+		});
+	});
+}
+
+void MprisArtCache::onPaletteExtracted(const QUrl& url, const QVector<QColor>& palette) {
+	this->extracting.remove(url);
+	if (!palette.isEmpty()) this->palettes.insert(url, new QVector<QColor>(palette));
+	emit this->paletteReady(url, palette);
+}
+
+QString MprisArtCache::diskPath(const QUrl& url) const {
+	auto hash = QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Sha1);
+	return this->dir.filePath(QString::fromLatin1(hash.toHex()));
+}
+
+void MprisArtCache::resolve(const QUrl& url, const PathCallback& callback) {
+	if (url.isLocalFile()) {
+		callback(url.toLocalFile());
+		return;
+	}
+
+	if (url.scheme() != "http" && url.scheme() != "https") {
+		qCWarning(logMprisArt) << "Unsupported album art url" << url;
+		callback("");
+		return;
+	}
+
+	if (!this->hasDir) {
+		callback("");
+		return;
+	}
+
+	auto path = this->diskPath(url);
+
+	if (QFile::exists(path)) {
+		// bump the file to the front of the disk cache
+		auto file = QFile(path);
+		if (file.open(QFile::ReadOnly)) {
+			file.setFileTime(QDateTime::currentDateTime(), QFile::FileModificationTime);
+		}
+
+		callback(path);
+		return;
+	}
+
+	auto& callbacks = this->downloads[url];
+	callbacks.append(callback);
+	if (callbacks.length() != 1) return;
+
+	qCDebug(logMprisArt) << "Downloading album art" << url;
+
+	auto* reply = this->network.get(QNetworkRequest(url));
+
+	QObject::connect(
+	    reply,
+	    &QNetworkReply::downloadProgress,
+	    this,
+	    [url, reply](qint64 received, qint64 total) {
+		    if (received > MAX_DOWNLOAD_BYTES || total > MAX_DOWNLOAD_BYTES) {
+			    qCWarning(logMprisArt) << "Album art" << url << "is too large, not downloading.";
+			    reply->abort();
+		    }
+	    }
+	);
+
+	QObject::connect(reply, &QNetworkReply::finished, this, [this, url, reply]() {
+		reply->deleteLater();
+
+		if (reply->error() != QNetworkReply::NoError) {
+			qCWarning(logMprisArt) << "Could not download album art" << url << reply->errorString();
+			this->onDownloaded(url, QByteArray());
+			return;
+		}
+
+		this->onDownloaded(url, reply->readAll());
+	});
+}
+
+void MprisArtCache::onDownloaded(const QUrl& url, const QByteArray& data) {
+	auto path = QString();
+
+	if (!data.isEmpty()) {
+		auto file = QSaveFile(this->diskPath(url));
+
+		if (file.open(QFile::WriteOnly) && file.write(data) == data.size() && file.commit()) {
+			path = file.fileName();
+			this->trimDiskCache();
+		} else {
+			qCWarning(logMprisArt) << "Could not write album art" << url << "to the cache:"
+			                       << file.errorString();
+		}
+	}
+
+	auto callbacks = this->downloads.take(url);
+	for (const auto& callback: callbacks) {
+		callback(path);
+	}
+}
+
+void MprisArtCache::trimDiskCache() {
+	// newest first
+	auto entries = this->dir.entryInfoList(QDir::Files, QDir::Time);
+	qint64 total = 0;
+
+	for (const auto& entry: entries) {
+		total += entry.size();
+
+		if (total > DISK_CACHE_BYTES) {
+			QFile::remove(entry.filePath());
+		}
+	}
+}
+
+MprisArtResponse::MprisArtResponse(const QUrl& url, const QSize& requestedSize)
+    : key(MprisArtCache::imageKey(url, requestedSize)) {
+	auto* cache = MprisArtCache::instance();
+
+	auto image = cache->cachedImage(this->key);
+	if (!image.isNull()) {
+		// finished can't be emitted before the response is returned
+		QMetaObject::invokeMethod(
+		    this,
+		    [this, image]() { this->finish(image); },
+		    Qt::QueuedConnection
+		);
+
+		return;
+	}
+
+	QObject::connect(
+	    cache,
+	    &MprisArtCache::imageReady,
+	    this,
+	    [this](const QString& readyKey, const QImage& image) {
+		    if (readyKey == this->key) this->finish(image);
+	    }
+	);
+
+	QMetaObject::invokeMethod(
+	    cache,
+	    [cache, key = this->key, url, requestedSize]() {
+		    cache->requestImage(key, url, requestedSize);
+	    },
+	    Qt::QueuedConnection
+	);
+}
+
+void MprisArtResponse::finish(const QImage& image) {
+	QObject::disconnect(MprisArtCache::instance(), nullptr, this, nullptr);
+	this->image = image;
+	emit this->finished();
+}
+
+QQuickTextureFactory* MprisArtResponse::textureFactory() const {
+	return QQuickTextureFactory::textureFactoryForImage(this->image);
+}
+
+QString MprisArtResponse::errorString() const {
+	return this->image.isNull() ? "Could not load album art" : "";
+}
+
+QQuickImageResponse*
+MprisArtProvider::requestImageResponse(const QString& id, const QSize& requestedSize) {
+	auto url = QUrl(QUrl::fromPercentEncoding(id.toUtf8()));
+	return new MprisArtResponse(url, requestedSize);
+}
+
+} // namespace qs::service::mpris
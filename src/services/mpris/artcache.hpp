@@ -0,0 +1,95 @@
+#pragma once
+
+#include <functional>
+
+#include <qcache.h>
+#include <qcolor.h>
+#include <qcontainerfwd.h>
+#include <qdir.h>
+#include <qhash.h>
+#include <qimage.h>
+#include <qmutex.h>
+#include <qnetworkaccessmanager.h>
+#include <qobject.h>
+#include <qquickimageprovider.h>
+#include <qset.h>
+#include <qsize.h>
+#include <qtmetamacros.h>
+#include <qurl.h>
+
+namespace qs::service::mpris {
+
+// Fetches, decodes and caches album art. Lives on the main thread.
+//
+// Remote art is downloaded once into a size bounded directory in the cache dir, and
+// decoded images are kept in a size bounded in memory cache keyed by url and size.
+class MprisArtCache: public QObject {
+	Q_OBJECT;
+
+public:
+	static MprisArtCache* instance();
+
+	// Returns the url of the image provider serving the given art url, or "" if there is none.
+	static QString providerUrl(const QString& artUrl);
+
+	// Thread safe. Returns a null image if the image is not cached in memory.
+	[[nodiscard]] QImage cachedImage(const QString& key);
+	[[nodiscard]] static QString imageKey(const QUrl& url, const QSize& size);
+
+	// Loads an image, emitting imageReady with the given key when done.
+	void requestImage(const QString& key, const QUrl& url, QSize size);
+	// Extracts the dominant colors of an image, emitting paletteReady when done.
+	void requestPalette(const QUrl& url);
+
+signals:
+	void imageReady(const QString& key, const QImage& image);
+	void paletteReady(const QUrl& url, const QVector<QColor>& palette);
+
+private:
+	using PathCallback = std::function<void(const QString& path)>;
+
+	explicit MprisArtCache();
+
+	// Resolves an art url to a local file, downloading it if required. The path is empty on failure.
+	void resolve(const QUrl& url, const PathCallback& callback);
+	void onDownloaded(const QUrl& url, const QByteArray& data);
+	void trimDiskCache();
+	[[nodiscard]] QString diskPath(const QUrl& url) const;
+
+	void onDecoded(const QString& key, const QImage& image);
+	void onPaletteExtracted(const QUrl& url, const QVector<QColor>& palette);
+
+	QMutex mutex;
+	QCache<QString, QImage> images;
+
+	QSet<QString> decoding;
+	QSet<QUrl> extracting;
+	QCache<QUrl, QVector<QColor>> palettes;
+
+	QNetworkAccessManager network;
+	QHash<QUrl, QVector<PathCallback>> downloads;
+	QDir dir;
+	bool hasDir = false;
+};
+
+class MprisArtResponse: public QQuickImageResponse {
+public:
+	explicit MprisArtResponse(const QUrl& url, const QSize& requestedSize);
+
+	[[nodiscard]] QQuickTextureFactory* textureFactory() const override;
+	[[nodiscard]] QString errorString() const override;
+
+private:
+	void finish(const QImage& image);
+
+	QString key;
+	QImage image;
+};
+
+// Serves `image://mprisart/<percent encoded art url>`.
+class MprisArtProvider: public QQuickAsyncImageProvider {
+public:
+	QQuickImageResponse* requestImageResponse(const QString& id, const QSize& requestedSize) override;
+};
+
+} // namespace qs::service::mpris
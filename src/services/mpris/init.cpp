@@ -0,0 +1,21 @@
+#include "../../core/generation.hpp"
+#include "../../core/plugin.hpp"
+#include "artcache.hpp"
+
+namespace qs::service::mpris {
+
+namespace {
+
+class MprisPlugin: public QuickshellPlugin {
+	void constructGeneration(EngineGeneration& generation) override {
+		// create the cache on the main thread before any image requests come in from loader threads
+		MprisArtCache::instance();
+		generation.engine->addImageProvider("mprisart", new MprisArtProvider());
+	}
+};
+
+QS_REGISTER_PLUGIN(MprisPlugin);
+
+} // namespace
+
+} // namespace qs::service::mpris
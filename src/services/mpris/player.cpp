@@ -1,18 +1,25 @@
 #include "player.hpp"
+#include <algorithm>
 
+#include <qabstractanimation.h>
+#include <qcolor.h>
 #include <qcontainerfwd.h>
 #include <qdatetime.h>
 #include <qdbusconnection.h>
 #include <qdbusextratypes.h>
+#include <qhash.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qobject.h>
 #include <qstring.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
+#include <qurl.h>
+#include <qvector.h>
 
 #include "../../core/util.hpp"
 #include "../../dbus/properties.hpp"
+#include "artcache.hpp"
 #include "dbus_player.h"
 #include "dbus_player_app.h"
 
@@ -22,6 +29,43 @@ namespace qs::service::mpris {
 
 Q_LOGGING_CATEGORY(logMprisPlayer, "quickshell.service.mp.player", QtWarningMsg);
 
+// Advances the position of every playing player with a positionResolution. Running as an
+// animation ticks it from Qt's unified animation timer while any player needs updates.
+class MprisPositionDriver: public QAbstractAnimation {
+public:
+	static MprisPositionDriver* instance() {
+		static auto* instance = new MprisPositionDriver(); // NOLINT
+		return instance;
+	}
+
+	void addPlayer(MprisPlayer* player) {
+		this->players.append(player);
+		if (this->state() != QAbstractAnimation::Running) this->start();
+	}
+
+	void removePlayer(MprisPlayer* player) {
+		this->players.removeOne(player);
+		if (this->players.isEmpty()) this->stop();
+	}
+
+	[[nodiscard]] int duration() const override { return -1; }
+
+protected:
+	void updateCurrentTime(int /*currentTime*/) override {
+		// players may be removed by signal handlers
+		auto players = this->players;
+
+		for (auto* player: players) {
+			if (this->players.contains(player)) player->updateDrivenPosition();
+		}
+	}
+
+private:
+	MprisPositionDriver() = default;
+
+	QVector<MprisPlayer*> players;
+};
+
 QString MprisPlaybackState::toString(MprisPlaybackState::Enum status) {
 	switch (status) {
 	case MprisPlaybackState::Stopped: return "Stopped";
@@ -87,18 +131,31 @@ MprisPlayer::MprisPlayer(const QString& address, QObject* parent): QObject(paren
 	QObject::connect(&this->pMaxRate, &AbstractDBusProperty::changed, this, &MprisPlayer::maxRateChanged);
 	QObject::connect(&this->pShuffle, &AbstractDBusProperty::changed, this, &MprisPlayer::shuffleChanged);
 
+	QObject::connect(&this->appProperties, &DBusPropertyGroup::getAllFinished, this, &MprisPlayer::onGetAllFinished);
 	QObject::connect(&this->playerProperties, &DBusPropertyGroup::getAllFinished, this, &MprisPlayer::onGetAllFinished);
 
+	QObject::connect(MprisArtCache::instance(), &MprisArtCache::paletteReady, this, &MprisPlayer::onTrackArtPaletteReady);
+
 	// Ensure user triggered position updates can update length.
 	QObject::connect(this, &MprisPlayer::positionChanged, this, &MprisPlayer::onExportedPositionChanged);
 	// clang-format on
 
+	// position updates also refresh the time the position was sampled at
+	this->pPosition.setAlwaysNotify(true);
+
 	this->appProperties.setInterface(this->app);
 	this->playerProperties.setInterface(this->player);
+
+	// both requests are in flight at once, and the player is ready once both have returned
+	this->pendingGetAlls = 2;
 	this->appProperties.updateAllViaGetAll();
 	this->playerProperties.updateAllViaGetAll();
 }
 
+MprisPlayer::~MprisPlayer() {
+	if (this->positionDriven) MprisPositionDriver::instance()->removePlayer(this);
+}
+
 void MprisPlayer::raise() {
 	if (!this->canRaise()) {
 		qWarning() << "Cannot call raise() on" << this << "because canRaise is false.";
@@ -219,7 +276,69 @@ void MprisPlayer::onPositionChanged() {
 	this->lastPositionTimestamp = QDateTime::currentDateTimeUtc();
 	this->pausedTime = this->lastPositionTimestamp;
 	emit this->positionChanged();
-	if (firstChange) emit this->positionSupportedChanged();
+
+	if (firstChange) {
+		emit this->positionSupportedChanged();
+		this->updatePositionDriver();
+	}
+}
+
+qreal MprisPlayer::positionResolution() const { return this->mPositionResolution; }
+
+void MprisPlayer::requestPositionResolution(const QObject* requester, qreal resolution) {
+	if (resolution > 0) {
+		this->positionResolutionRequests.insert(requester, resolution);
+	} else {
+		this->positionResolutionRequests.remove(requester);
+	}
+
+	this->updatePositionResolution();
+}
+
+void MprisPlayer::dropPositionResolutionRequest(const QObject* requester) {
+	if (this->positionResolutionRequests.remove(requester)) this->updatePositionResolution();
+}
+
+void MprisPlayer::updatePositionResolution() {
+	auto resolution = 0.0;
+
+	if (!this->positionResolutionRequests.isEmpty()) {
+		resolution = *std::min_element(
+		    this->positionResolutionRequests.cbegin(),
+		    this->positionResolutionRequests.cend()
+		);
+	}
+
+	if (resolution == this->mPositionResolution) return;
+
+	this->mPositionResolution = resolution;
+	this->lastPositionStep = -1;
+	this->updatePositionDriver();
+	emit this->positionResolutionChanged();
+}
+
+void MprisPlayer::updatePositionDriver() {
+	auto driven = this->mPositionResolution > 0 && this->positionSupported()
+	           && this->mPlaybackState == MprisPlaybackState::Playing;
+
+	if (driven == this->positionDriven) return;
+	this->positionDriven = driven;
+
+	if (driven) {
+		MprisPositionDriver::instance()->addPlayer(this);
+	} else {
+		MprisPositionDriver::instance()->removePlayer(this);
+	}
+}
+
+void MprisPlayer::updateDrivenPosition() {
+	auto resolutionMs = static_cast<qlonglong>(this->mPositionResolution * 1000);
+	resolutionMs = std::max<qlonglong>(resolutionMs, 1);
+	auto step = this->positionMs() / resolutionMs;
+
+	if (step == this->lastPositionStep) return;
+	this->lastPositionStep = step;
+	emit this->positionChanged();
 }
 
 void MprisPlayer::onExportedPositionChanged() {
@@ -311,6 +430,7 @@ void MprisPlayer::onMetadataChanged() {
 
 	auto trackArtUrl = this->pMetadata.get().value("mpris:artUrl").toString();
 	auto trackArtUrlChanged = this->setTrackArtUrl(trackArtUrl);
+	if (trackArtUrlChanged) this->resetTrackArtPalette();
 
 	if (trackChanged) {
 		this->mUniqueId++;
@@ -338,6 +458,40 @@ DEFINE_MEMBER_GETSET(MprisPlayer, trackAlbum, setTrackAlbum);
 DEFINE_MEMBER_GETSET(MprisPlayer, trackAlbumArtist, setTrackAlbumArtist);
 DEFINE_MEMBER_GETSET(MprisPlayer, trackArtUrl, setTrackArtUrl);
 
+QString MprisPlayer::trackArt() const { return MprisArtCache::providerUrl(this->mTrackArtUrl); }
+
+QVector<QColor> MprisPlayer::trackArtPalette() const {
+	this->requestTrackArtPalette();
+	return this->mTrackArtPalette;
+}
+
+void MprisPlayer::requestTrackArtPalette() const {
+	if (this->trackArtPaletteRequested || this->mTrackArtUrl.isEmpty()) return;
+	this->trackArtPaletteRequested = true;
+	MprisArtCache::instance()->requestPalette(QUrl(this->mTrackArtUrl));
+}
+
+void MprisPlayer::resetTrackArtPalette() {
+	auto watched = this->trackArtPaletteRequested;
+	this->trackArtPaletteRequested = false;
+
+	if (!this->mTrackArtPalette.isEmpty()) {
+		this->mTrackArtPalette.clear();
+		emit this->trackArtPaletteChanged();
+	}
+
+	// start extracting right away if the palette of the last track was used
+	if (watched) this->requestTrackArtPalette();
+}
+
+void MprisPlayer::onTrackArtPaletteReady(const QUrl& url, const QVector<QColor>& palette) {
+	if (!this->trackArtPaletteRequested || url != QUrl(this->mTrackArtUrl)) return;
+	if (palette == this->mTrackArtPalette) return;
+
+	this->mTrackArtPalette = palette;
+	emit this->trackArtPaletteChanged();
+}
+
 MprisPlaybackState::Enum MprisPlayer::playbackState() const { return this->mPlaybackState; }
 
 void MprisPlayer::setPlaybackState(MprisPlaybackState::Enum playbackState) {
@@ -407,6 +561,7 @@ void MprisPlayer::onPlaybackStatusChanged() {
 		// make sure we're in sync at least on play/pause. Some players don't automatically send this.
 		this->pPosition.update();
 		this->mPlaybackState = state;
+		this->updatePositionDriver();
 		emit this->playbackStateChanged();
 	}
 }
@@ -510,10 +665,56 @@ QList<QString> MprisPlayer::supportedUriSchemes() const { return this->pSupporte
 QList<QString> MprisPlayer::supportedMimeTypes() const { return this->pSupportedMimeTypes.get(); }
 
 void MprisPlayer::onGetAllFinished() {
+	if (this->pendingGetAlls == 0 || --this->pendingGetAlls != 0) return;
+
 	if (this->volumeSupported()) emit this->volumeSupportedChanged();
 	if (this->loopSupported()) emit this->loopSupportedChanged();
 	if (this->shuffleSupported()) emit this->shuffleSupportedChanged();
 	emit this->ready();
 }
 
+MprisPositionTracker::~MprisPositionTracker() {
+	if (this->mPlayer != nullptr) this->mPlayer->dropPositionResolutionRequest(this);
+}
+
+MprisPlayer* MprisPositionTracker::player() const { return this->mPlayer; }
+
+void MprisPositionTracker::setPlayer(MprisPlayer* player) {
+	if (player == this->mPlayer) return;
+
+	if (this->mPlayer != nullptr) {
+		QObject::disconnect(this->mPlayer, nullptr, this, nullptr);
+		this->mPlayer->dropPositionResolutionRequest(this);
+	}
+
+	if (player != nullptr) {
+		QObject::connect(player, &QObject::destroyed, this, &MprisPositionTracker::onPlayerDestroyed);
+	}
+
+	this->mPlayer = player;
+	this->updateRequest();
+	emit this->playerChanged();
+}
+
+void MprisPositionTracker::onPlayerDestroyed() {
+	this->mPlayer = nullptr;
+	emit this->playerChanged();
+}
+
+qreal MprisPositionTracker::resolution() const { return this->mResolution; }
+
+void MprisPositionTracker::setResolution(qreal resolution) {
+	resolution = std::max(resolution, 0.0);
+	if (resolution == this->mResolution) return;
+
+	this->mResolution = resolution;
+	this->updateRequest();
+	emit this->resolutionChanged();
+}
+
+void MprisPositionTracker::updateRequest() {
+	if (this->mPlayer == nullptr) return;
+	this->mPlayer->requestPositionResolution(this, this->mResolution);
+}
+
 } // namespace qs::service::mpris
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <qcolor.h>
 #include <qcontainerfwd.h>
+#include <qhash.h>
 #include <qobject.h>
 #include <qqmlintegration.h>
+#include <qtclasshelpermacros.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
+#include <qurl.h>
 
 #include "../../core/doc.hpp"
 #include "../../core/util.hpp"
@@ -14,6 +18,8 @@
 
 namespace qs::service::mpris {
 
+class MprisPositionDriver;
+
 ///! Playback state of an MprisPlayer
 /// See @@MprisPlayer.playbackState.
 class MprisPlaybackState: public QObject {
@@ -85,32 +91,22 @@ class MprisPlayer: public QObject {
 	/// > actively monitored, `position` usually will not update reactively, unless a nonlinear
 	/// > change in position occurs, however reading it will always return the current position.
 	/// >
-	/// > If you want to actively monitor the position, the simplest way it to emit the @@positionChanged(s)
-	/// > signal manually for the duration you are monitoring it, Using a @@QtQuick.FrameAnimation if you need
-	/// > the value to update smoothly, such as on a slider, or a @@QtQuick.Timer if not, as shown below.
+	/// > If you want to actively monitor the position, use an @@MprisPositionTracker to
+	/// > request how often the position should update while playing.
 	/// >
-	/// > ```qml {filename="Using a FrameAnimation"}
-	/// > FrameAnimation {
-	/// >   // only emit the signal when the position is actually changing.
-	/// >   running: player.playbackState == MprisPlaybackState.Playing
-	/// >   // emit the positionChanged signal every frame.
-	/// >   onTriggered: player.positionChanged()
-	/// > }
-	/// > ```
-	/// >
-	/// > ```qml {filename="Using a Timer"}
-	/// > Timer {
-	/// >   // only emit the signal when the position is actually changing.
-	/// >   running: player.playbackState == MprisPlaybackState.Playing
-	/// >   // Make sure the position updates at least once per second.
-	/// >   interval: 1000
-	/// >   repeat: true
-	/// >   // emit the positionChanged signal every second.
-	/// >   onTriggered: player.positionChanged()
+	/// > ```qml
+	/// > // update a text label whenever the displayed second changes
+	/// > MprisPositionTracker {
+	/// >   player: root.player
+	/// >   resolution: 1
 	/// > }
 	/// > ```
 	Q_PROPERTY(qreal position READ position WRITE setPosition NOTIFY positionChanged);
 	Q_PROPERTY(bool positionSupported READ positionSupported NOTIFY positionSupportedChanged);
+	/// How often @@position updates while the player is playing, in seconds of playback.
+	/// This is the finest @@MprisPositionTracker.resolution of any tracker following the player,
+	/// or 0 if automatic updates are disabled.
+	Q_PROPERTY(qreal positionResolution READ positionResolution NOTIFY positionResolutionChanged);
 	/// The length of the playing track, as seconds, with millisecond precision,
 	/// or the value of @@position if @@lengthSupported is false.
 	Q_PROPERTY(qreal length READ length NOTIFY lengthChanged);
@@ -144,6 +140,25 @@ class MprisPlayer: public QObject {
 	Q_PROPERTY(QVector<QString> trackArtists READ trackArtists NOTIFY trackArtistsChanged);
 	/// The current track's art url, or `""` if none was provided.
 	Q_PROPERTY(QString trackArtUrl READ trackArtUrl NOTIFY trackArtUrlChanged);
+	/// The current track's art loaded through quickshell's album art cache, or `""` if none was provided.
+	///
+	/// Unlike @@trackArtUrl, remote art is only downloaded once and kept on disk, and art is
+	/// decoded on a worker thread at the `sourceSize` of the image displaying it,
+	/// which avoids repeatedly decoding large covers.
+	///
+	/// ```qml
+	/// Image {
+	///   source: player.trackArt
+	///   sourceSize { width: 64; height: 64 }
+	/// }
+	/// ```
+	Q_PROPERTY(QString trackArt READ trackArt NOTIFY trackArtUrlChanged);
+	/// Up to 5 dominant colors of the current track's art, most prominent first,
+	/// or an empty list if there is no art.
+	///
+	/// Colors are extracted on a worker thread the first time this property is read
+	/// for a track, and will be empty until then.
+	Q_PROPERTY(QVector<QColor> trackArtPalette READ trackArtPalette NOTIFY trackArtPaletteChanged);
 	/// The playback state of the media player.
 	///
 	/// - If @@canPlay is false, you cannot assign the `Playing` state.
@@ -184,6 +199,8 @@ class MprisPlayer: public QObject {
 
 public:
 	explicit MprisPlayer(const QString& address, QObject* parent = nullptr);
+	~MprisPlayer() override;
+	Q_DISABLE_COPY_MOVE(MprisPlayer);
 
 	/// Bring the media player to the front of the window stack.
 	///
@@ -247,6 +264,11 @@ public:
 	[[nodiscard]] bool positionSupported() const;
 	void setPosition(qreal position);
 
+	[[nodiscard]] qreal positionResolution() const;
+	// Every MprisPositionTracker requests a resolution, and the finest request is used.
+	void requestPositionResolution(const QObject* requester, qreal resolution);
+	void dropPositionResolutionRequest(const QObject* requester);
+
 	[[nodiscard]] qreal length() const;
 	[[nodiscard]] bool lengthSupported() const;
 
@@ -275,6 +297,9 @@ public:
 	[[nodiscard]] bool fullscreen() const;
 	void setFullscreen(bool fullscreen);
 
+	[[nodiscard]] QString trackArt() const;
+	[[nodiscard]] QVector<QColor> trackArtPalette() const;
+
 	[[nodiscard]] QList<QString> supportedUriSchemes() const;
 	[[nodiscard]] QList<QString> supportedMimeTypes() const;
 
@@ -300,6 +325,7 @@ signals:
 	void desktopEntryChanged();
 	void positionChanged();
 	void positionSupportedChanged();
+	void positionResolutionChanged();
 	void lengthChanged();
 	void lengthSupportedChanged();
 	void volumeChanged();
@@ -310,6 +336,7 @@ signals:
 	void trackAlbumArtistChanged();
 	void trackArtistsChanged();
 	void trackArtUrlChanged();
+	void trackArtPaletteChanged();
 	void playbackStateChanged();
 	void loopStateChanged();
 	void loopSupportedChanged();
@@ -330,8 +357,16 @@ private slots:
 	void onMetadataChanged();
 	void onPlaybackStatusChanged();
 	void onLoopStatusChanged();
+	void onTrackArtPaletteReady(const QUrl& url, const QVector<QColor>& palette);
 
 private:
+	void updatePositionResolution();
+	void updatePositionDriver();
+	void resetTrackArtPalette();
+	void requestTrackArtPalette() const;
+	// Emits positionChanged if the position has crossed a resolution step. Called by the driver.
+	void updateDrivenPosition();
+
 	// clang-format off
 	dbus::DBusPropertyGroup appProperties;
 	dbus::DBusProperty<QString> pIdentity {this->appProperties, "Identity"};
@@ -366,6 +401,11 @@ private:
 	QDateTime lastPositionTimestamp;
 	QDateTime pausedTime;
 	qlonglong mLength = -1;
+	qreal mPositionResolution = 0;
+	QHash<const QObject*, qreal> positionResolutionRequests;
+	qlonglong lastPositionStep = -1;
+	bool positionDriven = false;
+	qint32 pendingGetAlls = 0;
 
 	DBusMprisPlayerApp* app = nullptr;
 	DBusMprisPlayer* player = nullptr;
@@ -377,6 +417,8 @@ private:
 	QString mTrackAlbum;
 	QString mTrackAlbumArtist;
 	QString mTrackArtUrl;
+	QVector<QColor> mTrackArtPalette;
+	mutable bool trackArtPaletteRequested = false;
 
 	DECLARE_MEMBER_NS(MprisPlayer, uniqueId, mUniqueId);
 
@@ -393,6 +435,69 @@ private:
 
 public:
 	DECLARE_MEMBER_GET(uniqueId);
+
+	friend class MprisPositionDriver;
+};
+
+///! Keeps the position of an MprisPlayer updated.
+/// Makes @@MprisPlayer.position update reactively while the player is playing.
+///
+/// @@MprisPlayer.positionChanged(s) is emitted each time the position crosses a multiple of
+/// @@resolution, so a resolution of `1` updates exactly when the whole number of seconds changes.
+///
+/// Any number of trackers may follow the same player, and the player updates as often as the
+/// finest resolution requested by any of them.
+///
+/// #### Example
+/// ```qml
+/// Text {
+///   text: Math.floor(player.position)
+///
+///   MprisPositionTracker {
+///     player: root.player
+///     resolution: 1
+///   }
+/// }
+/// ```
+class MprisPositionTracker: public QObject {
+	Q_OBJECT;
+	// clang-format off
+	/// The player to keep updated.
+	Q_PROPERTY(qs::service::mpris::MprisPlayer* player READ player WRITE setPlayer NOTIFY playerChanged);
+	/// How often the position should update while playing, in seconds of playback.
+	/// Defaults to 0, which requests no updates.
+	///
+	/// Updates are driven by Qt's animation timer, which ticks about once per frame
+	/// (16ms by default) but is not synchronized with the frames of any window.
+	/// A value smaller than a tick, such as `0.001`, updates every tick, which is suitable
+	/// for progress bars.
+	Q_PROPERTY(qreal resolution READ resolution WRITE setResolution NOTIFY resolutionChanged);
+	// clang-format on
+	QML_ELEMENT;
+
+public:
+	explicit MprisPositionTracker(QObject* parent = nullptr): QObject(parent) {}
+	~MprisPositionTracker() override;
+	Q_DISABLE_COPY_MOVE(MprisPositionTracker);
+
+	[[nodiscard]] MprisPlayer* player() const;
+	void setPlayer(MprisPlayer* player);
+
+	[[nodiscard]] qreal resolution() const;
+	void setResolution(qreal resolution);
+
+signals:
+	void playerChanged();
+	void resolutionChanged();
+
+private slots:
+	void onPlayerDestroyed();
+
+private:
+	void updateRequest();
+
+	MprisPlayer* mPlayer = nullptr;
+	qreal mResolution = 0;
 };
 
 } // namespace qs::service::mpris
@@ -2,12 +2,15 @@
 
 #include <qcontainerfwd.h>
 #include <qdbusconnection.h>
-#include <qdbusconnectioninterface.h>
+#include <qdbusmessage.h>
+#include <qdbuspendingcall.h>
+#include <qdbuspendingreply.h>
 #include <qdbusservicewatcher.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qobject.h>
 #include <qqmllist.h>
+#include <qstringlist.h>
 
 #include "../../core/model.hpp"
 #include "player.hpp"
@@ -42,13 +45,37 @@ MprisWatcher::MprisWatcher() {
 }
 
 void MprisWatcher::registerExisting() {
-	const QStringList& list = QDBusConnection::sessionBus().interface()->registeredServiceNames();
-	for (const QString& service: list) {
-		if (service.startsWith("org.mpris.MediaPlayer2")) {
-			qCDebug(logMprisWatcher).noquote() << "Found Mpris service" << service;
-			this->registerPlayer(service);
+	auto message = QDBusMessage::createMethodCall(
+	    "org.freedesktop.DBus",
+	    "/org/freedesktop/DBus",
+	    "org.freedesktop.DBus",
+	    "ListNames"
+	);
+
+	auto pendingCall = QDBusConnection::sessionBus().asyncCall(message);
+	auto* call = new QDBusPendingCallWatcher(pendingCall, this);
+	// players found before the listing finishes are published together with the listed ones
+	this->readyBatcher.setHeld(true);
+
+	auto responseCallback = [this](QDBusPendingCallWatcher* call) {
+		const QDBusPendingReply<QStringList> reply = *call;
+
+		if (reply.isError()) {
+			qCWarning(logMprisWatcher) << "Error listing existing Mpris services:" << reply.error();
+		} else {
+			for (const QString& service: reply.value()) {
+				if (service.startsWith("org.mpris.MediaPlayer2")) {
+					qCDebug(logMprisWatcher).noquote() << "Found Mpris service" << service;
+					this->registerPlayer(service);
+				}
+			}
 		}
-	}
+
+		delete call;
+		this->readyBatcher.setHeld(false);
+	};
+
+	QObject::connect(call, &QDBusPendingCallWatcher::finished, this, responseCallback);
 }
 
 void MprisWatcher::onServiceRegistered(const QString& service) {
@@ -72,11 +99,17 @@ void MprisWatcher::onServiceUnregistered(const QString& service) {
 
 void MprisWatcher::onPlayerReady() {
 	auto* player = qobject_cast<MprisPlayer*>(this->sender());
-	this->readyPlayers.insertObject(player);
+	if (player != nullptr) this->readyBatcher.setReady(player);
+}
+
+void MprisWatcher::publishReadyPlayers(const QVector<MprisPlayer*>& players) {
+	qCDebug(logMprisWatcher) << "Publishing" << players.length() << "ready MprisPlayers";
+	this->readyPlayers.insertObjects(players);
 }
 
 void MprisWatcher::onPlayerDestroyed(QObject* object) {
 	auto* player = static_cast<MprisPlayer*>(object); // NOLINT
+	this->readyBatcher.remove(player);
 	this->readyPlayers.removeObject(player);
 }
 
@@ -96,6 +129,7 @@ void MprisWatcher::registerPlayer(const QString& address) {
 	}
 
 	this->mPlayers.insert(address, player);
+	this->readyBatcher.addLoading(player);
 	QObject::connect(player, &MprisPlayer::ready, this, &MprisWatcher::onPlayerReady);
 	QObject::connect(player, &QObject::destroyed, this, &MprisWatcher::onPlayerDestroyed);
 
@@ -4,6 +4,7 @@
 #include <qdbusinterface.h>
 #include <qdbusservicewatcher.h>
 #include <qhash.h>
+#include <qlist.h>
 #include <qloggingcategory.h>
 #include <qobject.h>
 #include <qqmlintegration.h>
@@ -35,10 +36,12 @@ private:
 
 	void registerExisting();
 	void registerPlayer(const QString& address);
+	void publishReadyPlayers(const QVector<MprisPlayer*>& players);
 
 	QDBusServiceWatcher serviceWatcher;
 	QHash<QString, MprisPlayer*> mPlayers;
 	ObjectModel<MprisPlayer> readyPlayers {this};
+	ReadyBatcher<MprisPlayer> readyBatcher {this, &MprisWatcher::publishReadyPlayers};
 };
 
 class MprisQml: public QObject {
@@ -1,69 +1,104 @@
 #include "dbusimage.hpp"
+#include <algorithm>
+#include <utility>
 
 #include <qdbusargument.h>
 #include <qimage.h>
 #include <qloggingcategory.h>
 #include <qsize.h>
-#include <qsysinfo.h>
 #include <qtypes.h>
 
+#include "../../core/asyncimage.hpp"
+
 namespace qs::service::notifications {
 
 Q_DECLARE_LOGGING_CATEGORY(logNotifications); // server.cpp
 
 QImage DBusNotificationImage::createImage() const {
+	if (this->width <= 0 || this->height <= 0) return QImage();
+
 	auto format = this->hasAlpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888;
+	auto rowBytes = static_cast<qsizetype>(this->width) * (this->hasAlpha ? 4 : 3);
+
+	if (this->rowstride < rowBytes) {
+		qCWarning(logNotifications) << "Ignoring notification image with a rowstride of"
+		                            << this->rowstride << "which is shorter than its rows.";
+		return QImage();
+	}
+
+	// the last row is not required to be padded
+	auto dataSize = static_cast<qsizetype>(this->rowstride) * (this->height - 1) + rowBytes;
 
-	return QImage(
-	    reinterpret_cast<const uchar*>(this->data.data()), // NOLINT
+	if (this->data.size() < dataSize) {
+		qCWarning(logNotifications) << "Ignoring notification image with too little data for its size.";
+		return QImage();
+	}
+
+	// senders such as libnotify pad rows to 4 bytes, but not every sender does,
+	// so the sent stride is used instead of QImage's default
+	auto image = QImage(
+	    reinterpret_cast<const uchar*>(this->data.constData()), // NOLINT
 	    this->width,
 	    this->height,
+	    this->rowstride,
 	    format
 	);
+
+	// converting detaches the image from the data buffer
+	return image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
 }
 
 const QDBusArgument& operator>>(const QDBusArgument& argument, DBusNotificationImage& pixmap) {
 	argument.beginStructure();
 	argument >> pixmap.width;
 	argument >> pixmap.height;
-	auto rowstride = qdbus_cast<qint32>(argument);
+	argument >> pixmap.rowstride;
 	argument >> pixmap.hasAlpha;
 	auto sampleBits = qdbus_cast<qint32>(argument);
 	auto channels = qdbus_cast<qint32>(argument);
 	argument >> pixmap.data;
 	argument.endStructure();
 
+	auto expectedChannels = pixmap.hasAlpha ? 4 : 3;
+
 	if (sampleBits != 8) {
 		qCWarning(logNotifications) << "Unable to parse pixmap as sample count is incorrect. Got"
 		                            << sampleBits << "expected" << 8;
-	} else if (channels != (pixmap.hasAlpha ? 4 : 3)) {
+	} else if (channels != expectedChannels) {
 		qCWarning(logNotifications) << "Unable to parse pixmap as channel count is incorrect."
-		                            << "Got " << channels << "expected" << (pixmap.hasAlpha ? 4 : 3);
-	} else if (rowstride != pixmap.width * sampleBits * channels) {
+		                            << "Got " << channels << "expected" << expectedChannels;
+	} else if (pixmap.rowstride < pixmap.width * channels) {
 		qCWarning(logNotifications) << "Unable to parse pixmap as rowstride is incorrect. Got"
-		                            << rowstride << "expected"
-		                            << (pixmap.width * sampleBits * channels);
+		                            << pixmap.rowstride << "expected at least"
+		                            << (pixmap.width * channels);
 	}
 
 	return argument;
 }
 
 const QDBusArgument& operator<<(QDBusArgument& argument, const DBusNotificationImage& pixmap) {
+	auto channels = pixmap.hasAlpha ? 4 : 3;
+
 	argument.beginStructure();
 	argument << pixmap.width;
 	argument << pixmap.height;
-	argument << pixmap.width * (pixmap.hasAlpha ? 4 : 3) * 8;
+	argument << std::max(pixmap.rowstride, pixmap.width * channels);
 	argument << pixmap.hasAlpha;
 	argument << 8;
-	argument << (pixmap.hasAlpha ? 4 : 3);
+	argument << channels;
 	argument << pixmap.data;
 	argument.endStructure();
 	return argument;
 }
 
+NotificationImage::NotificationImage(DBusNotificationImage image, QObject* parent)
+    : QsImageHandle(QQuickAsyncImageProvider::Image, parent)
+    , image(std::move(image))
+    , decoded(AsyncImage::start([image = this->image]() { return image.createImage(); })) {}
+
 QImage
 NotificationImage::requestImage(const QString& /*unused*/, QSize* size, const QSize& /*unused*/) {
-	auto image = this->image.createImage();
+	auto image = this->decoded->image();
 
 	if (size != nullptr) *size = image.size();
 	return image;
@@ -1,11 +1,12 @@
 #pragma once
 
-#include <utility>
+#include <memory>
 
 #include <qdbusargument.h>
 #include <qimage.h>
 #include <qobject.h>
 
+#include "../../core/asyncimage.hpp"
 #include "../../core/imageprovider.hpp"
 
 namespace qs::service::notifications {
@@ -13,24 +14,28 @@ namespace qs::service::notifications {
 struct DBusNotificationImage {
 	qint32 width = 0;
 	qint32 height = 0;
+	// bytes per row, which may include padding
+	qint32 rowstride = 0;
 	bool hasAlpha = false;
 	QByteArray data;
 
-	// valid only for the lifetime of the pixmap
+	// Returns a premultiplied copy of the image, or a null image if the data is invalid.
 	[[nodiscard]] QImage createImage() const;
 };
 
 const QDBusArgument& operator>>(const QDBusArgument& argument, DBusNotificationImage& pixmap);
 const QDBusArgument& operator<<(QDBusArgument& argument, const DBusNotificationImage& pixmap);
 
+// Decoded on a worker thread as soon as it is created.
 class NotificationImage: public QsImageHandle {
 public:
-	explicit NotificationImage(DBusNotificationImage image, QObject* parent)
-	    : QsImageHandle(QQuickAsyncImageProvider::Image, parent)
-	    , image(std::move(image)) {}
+	explicit NotificationImage(DBusNotificationImage image, QObject* parent);
 
 	QImage requestImage(const QString& id, QSize* size, const QSize& requestedSize) override;
 
 	DBusNotificationImage image;
+
+private:
+	std::shared_ptr<AsyncImage> decoded;
 };
 } // namespace qs::service::notifications
@@ -0,0 +1,595 @@
+#include "history.hpp"
+#include <algorithm>
+
+#include <qabstractitemmodel.h>
+#include <qbytearray.h>
+#include <qcontainerfwd.h>
+#include <qdatastream.h>
+#include <qdatetime.h>
+#include <qfile.h>
+#include <qhashfunctions.h>
+#include <qlogging.h>
+#include <qloggingcategory.h>
+#include <qnamespace.h>
+#include <qobject.h>
+#include <qqmlengine.h>
+#include <qsavefile.h>
+#include <qtypes.h>
+#include <qvariant.h>
+
+#include "../../core/paths.hpp"
+#include "dbusimage.hpp"
+#include "notification.hpp"
+
+namespace qs::service::notifications {
+
+Q_LOGGING_CATEGORY(logHistory, "quickshell.service.notifications.history", QtWarningMsg);
+
+namespace {
+
+constexpr quint32 HISTORY_MAGIC = 0x71736e68; // "qsnh"
+constexpr quint32 HISTORY_VERSION = 2;
+constexpr qsizetype DEFAULT_CAPACITY = 100;
+
+enum HistoryRecordType : quint8 {
+	RecordImage = 1,
+	RecordEntry = 2,
+};
+
+// The history file is rewritten once it holds this many times more entries than the
+// history itself, as evicted entries are never removed from it otherwise.
+constexpr qsizetype COMPACT_FACTOR = 2;
+constexpr qsizetype COMPACT_MIN_ENTRIES = 64;
+
+NotificationHistoryStore* historyInstance = nullptr; // NOLINT
+
+} // namespace
+
+quint32 HistoryStringPool::ref(const QString& string) {
+	if (string.isEmpty()) return 0;
+
+	auto id = this->ids.value(string);
+
+	if (id == 0) {
+		if (this->freeEntries.isEmpty()) {
+			id = static_cast<quint32>(this->entries.length());
+			this->entries.append(Entry());
+		} else {
+			id = this->freeEntries.takeLast();
+		}
+
+		this->entries[id].string = string;
+		this->ids.insert(string, id);
+	}
+
+	this->entries[id].refs++;
+	return id;
+}
+
+void HistoryStringPool::unref(quint32 id) {
+	if (id == 0) return;
+
+	auto& entry = this->entries[id];
+	if (--entry.refs != 0) return;
+
+	this->ids.remove(entry.string);
+	entry.string = QString();
+	this->freeEntries.append(id);
+}
+
+const QString& HistoryStringPool::get(quint32 id) const { return this->entries.at(id).string; }
+
+size_t qHash(const HistoryImageKey& key, size_t seed) {
+	return qHashMulti(seed, key.width, key.height, key.rowstride, key.hasAlpha, key.data);
+}
+
+NotificationHistoryStore::NotificationHistoryStore() { this->setCapacity(DEFAULT_CAPACITY); }
+
+NotificationHistoryStore* NotificationHistoryStore::instance() {
+	if (historyInstance == nullptr) {
+		historyInstance = new NotificationHistoryStore();
+
+		// Wait for the creating component to finish so its capacity applies before loading.
+		QMetaObject::invokeMethod(
+		    historyInstance,
+		    &NotificationHistoryStore::load,
+		    Qt::QueuedConnection
+		);
+	}
+
+	return historyInstance;
+}
+
+void NotificationHistoryStore::recordClosed(
+    Notification* notification,
+    NotificationCloseReason::Enum reason
+) {
+	if (historyInstance == nullptr || notification->transient()) return;
+
+	auto record = Record {
+	    .time = notification->receivedTime.toMSecsSinceEpoch(),
+	    .appName = notification->appName(),
+	    .appIcon = notification->appIcon(),
+	    .summary = notification->summary(),
+	    .body = notification->body(),
+	    .desktopEntry = notification->desktopEntry(),
+	    .imagePath = notification->mImagePath,
+	    .urgency = static_cast<quint8>(notification->urgency()),
+	    .closeReason = static_cast<quint8>(reason),
+	};
+
+	if (const auto* pixmap = notification->mImagePixmap) {
+		record.image = HistoryImageKey {
+		    .width = pixmap->image.width,
+		    .height = pixmap->image.height,
+		    .rowstride = pixmap->image.rowstride,
+		    .hasAlpha = pixmap->image.hasAlpha,
+		    .data = pixmap->image.data,
+		};
+	}
+
+	historyInstance->append(record, true);
+}
+
+qsizetype NotificationHistoryStore::count() const { return this->mCount; }
+qsizetype NotificationHistoryStore::capacity() const { return this->mCapacity; }
+
+void NotificationHistoryStore::setCapacity(qsizetype capacity) {
+	capacity = std::max(capacity, static_cast<qsizetype>(0));
+	if (capacity == this->mCapacity) return;
+
+	if (this->mCount > capacity) this->removeOldest(this->mCount - capacity);
+
+	// move the remaining entries to the start of the resized columns
+	auto relayout = [&](auto& column) {
+		auto old = column;
+		column.resize(capacity);
+
+		for (qsizetype i = 0; i != this->mCount; i++) {
+			column[i] = old.at((this->oldest + i) % this->mCapacity);
+		}
+	};
+
+	relayout(this->serials);
+	relayout(this->times);
+	relayout(this->appNames);
+	relayout(this->appIcons);
+	relayout(this->summaries);
+	relayout(this->bodies);
+	relayout(this->desktopEntries);
+	relayout(this->imagePaths);
+	relayout(this->images);
+	relayout(this->urgencies);
+	relayout(this->closeReasons);
+
+	this->oldest = 0;
+	this->mCapacity = capacity;
+}
+
+void NotificationHistoryStore::requestCapacity(const QObject* requester, qsizetype capacity) {
+	this->capacityRequests.insert(requester, std::max(capacity, static_cast<qsizetype>(0)));
+	this->updateCapacity();
+}
+
+void NotificationHistoryStore::dropCapacityRequest(const QObject* requester) {
+	this->capacityRequests.remove(requester);
+	this->updateCapacity();
+}
+
+void NotificationHistoryStore::updateCapacity() {
+	// keep the history as is while no NotificationHistory exists, e.g. during a reload
+	if (this->capacityRequests.isEmpty()) return;
+	auto& requests = this->capacityRequests;
+	this->setCapacity(*std::max_element(requests.cbegin(), requests.cend()));
+}
+
+void NotificationHistoryStore::clear() {
+	emit this->aboutToReset();
+
+	while (this->mCount != 0) {
+		this->releaseSlot(this->oldest);
+		this->oldest = (this->oldest + 1) % this->mCapacity;
+		this->mCount--;
+	}
+
+	this->oldest = 0;
+	emit this->reset();
+
+	if (!this->path.isEmpty()) this->compact();
+}
+
+qsizetype NotificationHistoryStore::slotOf(qsizetype index) const {
+	return (this->oldest + this->mCount - 1 - index) % this->mCapacity;
+}
+
+NotificationHistoryEntry* NotificationHistoryStore::entry(qsizetype index) {
+	if (index < 0 || index >= this->mCount) return nullptr;
+
+	auto slot = this->slotOf(index);
+	auto serial = this->serials.at(slot);
+
+	if (auto* entry = this->liveEntries.value(serial).data()) return entry;
+
+	auto* entry = new NotificationHistoryEntry();
+	entry->time = QDateTime::fromMSecsSinceEpoch(this->times.at(slot));
+	entry->appName = this->strings.get(this->appNames.at(slot));
+	entry->appIcon = this->strings.get(this->appIcons.at(slot));
+	entry->summary = this->strings.get(this->summaries.at(slot));
+	entry->body = this->strings.get(this->bodies.at(slot));
+	entry->desktopEntry = this->strings.get(this->desktopEntries.at(slot));
+	entry->urgency = static_cast<NotificationUrgency::Enum>(this->urgencies.at(slot));
+	entry->closeReason = static_cast<NotificationCloseReason::Enum>(this->closeReasons.at(slot));
+
+	if (auto imageId = this->images.at(slot)) {
+		auto& image = this->imagePool[imageId];
+
+		if (image.handle == nullptr) {
+			image.handle = new NotificationImage(
+			    DBusNotificationImage {
+			        .width = image.key.width,
+			        .height = image.key.height,
+			        .rowstride = image.key.rowstride,
+			        .hasAlpha = image.key.hasAlpha,
+			        .data = image.key.data,
+			    },
+			    this
+			);
+		}
+
+		entry->image = image.handle->url();
+	} else {
+		entry->image = this->strings.get(this->imagePaths.at(slot));
+	}
+
+	// garbage collected once no view displays it
+	QQmlEngine::setObjectOwnership(entry, QQmlEngine::JavaScriptOwnership);
+	this->liveEntries.insert(serial, entry);
+	return entry;
+}
+
+void NotificationHistoryStore::append(const Record& record, bool persist) {
+	if (this->mCapacity == 0) return;
+	if (this->mCount == this->mCapacity) this->removeOldest(1);
+
+	emit this->aboutToPrepend();
+
+	auto slot = (this->oldest + this->mCount) % this->mCapacity;
+	this->serials[slot] = this->nextSerial++;
+	this->times[slot] = record.time;
+	this->appNames[slot] = this->strings.ref(record.appName);
+	this->appIcons[slot] = this->strings.ref(record.appIcon);
+	this->summaries[slot] = this->strings.ref(record.summary);
+	this->bodies[slot] = this->strings.ref(record.body);
+	this->desktopEntries[slot] = this->strings.ref(record.desktopEntry);
+	this->imagePaths[slot] = this->strings.ref(record.imagePath);
+	this->images[slot] = record.image.data.isEmpty() ? 0 : this->refImage(record.image);
+	this->urgencies[slot] = record.urgency;
+	this->closeReasons[slot] = record.closeReason;
+	this->mCount++;
+
+	emit this->prepended();
+
+	if (persist && this->file.isOpen()) {
+		this->writeRecord(this->stream, record, this->images.at(slot));
+		this->file.flush();
+		this->fileEntries++;
+
+		if (this->fileEntries > std::max(this->mCapacity * COMPACT_FACTOR, COMPACT_MIN_ENTRIES)) {
+			this->compact();
+		}
+	}
+}
+
+void NotificationHistoryStore::removeOldest(qsizetype count) {
+	emit this->aboutToRemoveOldest(count);
+
+	for (qsizetype i = 0; i != count; i++) {
+		this->releaseSlot(this->oldest);
+		this->oldest = (this->oldest + 1) % this->mCapacity;
+		this->mCount--;
+	}
+
+	emit this->removedOldest();
+}
+
+void NotificationHistoryStore::releaseSlot(qsizetype slot) {
+	this->strings.unref(this->appNames.at(slot));
+	this->strings.unref(this->appIcons.at(slot));
+	this->strings.unref(this->summaries.at(slot));
+	this->strings.unref(this->bodies.at(slot));
+	this->strings.unref(this->desktopEntries.at(slot));
+	this->strings.unref(this->imagePaths.at(slot));
+	this->unrefImage(this->images.at(slot));
+	this->liveEntries.remove(this->serials.at(slot));
+}
+
+NotificationHistoryStore::Record NotificationHistoryStore::recordAt(qsizetype slot) const {
+	auto record = Record {
+	    .time = this->times.at(slot),
+	    .appName = this->strings.get(this->appNames.at(slot)),
+	    .appIcon = this->strings.get(this->appIcons.at(slot)),
+	    .summary = this->strings.get(this->summaries.at(slot)),
+	    .body = this->strings.get(this->bodies.at(slot)),
+	    .desktopEntry = this->strings.get(this->desktopEntries.at(slot)),
+	    .imagePath = this->strings.get(this->imagePaths.at(slot)),
+	    .urgency = this->urgencies.at(slot),
+	    .closeReason = this->closeReasons.at(slot),
+	};
+
+	if (auto imageId = this->images.at(slot)) record.image = this->imagePool.at(imageId).key;
+	return record;
+}
+
+quint32 NotificationHistoryStore::refImage(const HistoryImageKey& key) {
+	auto id = this->imageIds.value(key);
+
+	if (id == 0) {
+		if (this->freeImages.isEmpty()) {
+			id = static_cast<quint32>(this->imagePool.length());
+			this->imagePool.append(Image());
+		} else {
+			id = this->freeImages.takeLast();
+		}
+
+		this->imagePool[id].key = key;
+		this->imageIds.insert(key, id);
+	}
+
+	this->imagePool[id].refs++;
+	return id;
+}
+
+void NotificationHistoryStore::unrefImage(quint32 id) {
+	if (id == 0) return;
+
+	auto& image = this->imagePool[id];
+	if (--image.refs != 0) return;
+
+	this->imageIds.remove(image.key);
+	delete image.handle;
+	image = Image();
+	this->freeImages.append(id);
+}
+
+void NotificationHistoryStore::load() {
+	auto* cacheDir = QsPaths::instance()->cacheDir();
+	if (cacheDir == nullptr) {
+		qCWarning(logHistory) << "No cache directory. Notification history will not persist.";
+		return;
+	}
+
+	this->loadFile(cacheDir->filePath("notification-history"));
+}
+
+void NotificationHistoryStore::loadFile(const QString& path) {
+	this->path = path;
+
+	auto input = QFile(this->path);
+	auto needsCompact = false;
+
+	if (input.open(QFile::ReadOnly) && input.size() != 0) {
+		auto* mapped = input.map(0, input.size());
+
+		if (mapped == nullptr) {
+			qCWarning(logHistory) << "Failed to map notification history" << this->path;
+			needsCompact = true;
+		} else {
+			auto data = QByteArray::fromRawData(
+			    reinterpret_cast<const char*>(mapped), // NOLINT
+			    input.size()
+			);
+
+			auto in = QDataStream(data);
+			in.setVersion(QDataStream::Qt_6_0);
+
+			quint32 magic = 0;
+			quint32 version = 0;
+			in >> magic >> version;
+
+			if (magic != HISTORY_MAGIC || version != HISTORY_VERSION) {
+				qCWarning(logHistory) << "Discarding incompatible notification history.";
+				needsCompact = true;
+			} else {
+				auto fileImages = QHash<quint32, HistoryImageKey>();
+
+				while (!in.atEnd()) {
+					quint8 type = 0;
+					in >> type;
+
+					if (type == RecordImage) {
+						quint32 id = 0;
+						auto key = HistoryImageKey();
+						in >> id >> key.width >> key.height >> key.rowstride >> key.hasAlpha >> key.data;
+						fileImages.insert(id, key);
+						this->nextFileImageId = std::max(this->nextFileImageId, id + 1);
+					} else if (type == RecordEntry) {
+						auto record = Record();
+						quint32 imageId = 0;
+
+						in >> record.time >> record.appName >> record.appIcon >> record.summary >> record.body
+						    >> record.desktopEntry >> record.imagePath >> record.urgency >> record.closeReason
+						    >> imageId;
+
+						if (in.status() != QDataStream::Ok) break;
+
+						record.image = fileImages.value(imageId);
+						this->append(record, false);
+						this->fileEntries++;
+
+						// the image is already defined in the file and doesn't need to be written again
+						if (auto poolId = this->images.at(this->slotOf(0))) {
+							auto& image = this->imagePool[poolId];
+							if (image.fileId == 0) image.fileId = imageId;
+						}
+					} else {
+						in.setStatus(QDataStream::ReadCorruptData);
+					}
+
+					if (in.status() != QDataStream::Ok) break;
+				}
+
+				if (in.status() != QDataStream::Ok) {
+					// usually a record cut off by a crash
+					qCWarning(logHistory) << "Notification history is damaged, keeping"
+					                      << this->mCount << "readable entries.";
+					needsCompact = true;
+				}
+			}
+
+			input.unmap(mapped);
+		}
+	}
+
+	input.close();
+
+	if (needsCompact
+	    || this->fileEntries > std::max(this->mCapacity * COMPACT_FACTOR, COMPACT_MIN_ENTRIES))
+	{
+		this->compact();
+	} else {
+		this->openFile();
+	}
+}
+
+void NotificationHistoryStore::openFile() {
+	this->stream.setDevice(nullptr);
+	this->file.close();
+	this->file.setFileName(this->path);
+
+	if (!this->file.open(QFile::WriteOnly | QFile::Append)) {
+		qCWarning(logHistory) << "Failed to open notification history" << this->path
+		                      << "for writing:" << this->file.errorString();
+		return;
+	}
+
+	this->stream.setDevice(&this->file);
+	this->stream.setVersion(QDataStream::Qt_6_0);
+
+	if (this->file.size() == 0) {
+		this->stream << HISTORY_MAGIC << HISTORY_VERSION;
+		this->file.flush();
+	}
+}
+
+void NotificationHistoryStore::writeRecord(
+    QDataStream& stream,
+    const Record& record,
+    quint32 imageId
+) {
+	quint32 fileImageId = 0;
+
+	if (imageId != 0) {
+		auto& image = this->imagePool[imageId];
+
+		// images are written once and referenced by every entry using them
+		if (image.fileId == 0) {
+			image.fileId = this->nextFileImageId++;
+
+			stream << static_cast<quint8>(RecordImage) << image.fileId << image.key.width
+			       << image.key.height << image.key.rowstride << image.key.hasAlpha << image.key.data;
+		}
+
+		fileImageId = image.fileId;
+	}
+
+	stream << static_cast<quint8>(RecordEntry) << record.time << record.appName << record.appIcon
+	       << record.summary << record.body << record.desktopEntry << record.imagePath
+	       << record.urgency << record.closeReason << fileImageId;
+}
+
+void NotificationHistoryStore::compact() {
+	this->stream.setDevice(nullptr);
+	this->file.close();
+
+	auto output = QSaveFile(this->path);
+	if (!output.open(QFile::WriteOnly)) {
+		qCWarning(logHistory) << "Failed to rewrite notification history" << this->path
+		                      << "-" << output.errorString();
+		return;
+	}
+
+	for (auto& image: this->imagePool) {
+		image.fileId = 0;
+	}
+
+	this->nextFileImageId = 1;
+
+	auto out = QDataStream(&output);
+	out.setVersion(QDataStream::Qt_6_0);
+	out << HISTORY_MAGIC << HISTORY_VERSION;
+
+	for (auto i = this->mCount - 1; i >= 0; i--) {
+		auto slot = this->slotOf(i);
+		this->writeRecord(out, this->recordAt(slot), this->images.at(slot));
+	}
+
+	if (!output.commit()) {
+		qCWarning(logHistory) << "Failed to rewrite notification history" << this->path
+		                      << "-" << output.errorString();
+		return;
+	}
+
+	this->fileEntries = this->mCount;
+	this->openFile();
+}
+
+NotificationHistory::NotificationHistory(QObject* parent)
+    : QAbstractListModel(parent)
+    , store(NotificationHistoryStore::instance())
+    , mCapacity(DEFAULT_CAPACITY) {
+	auto* store = this->store;
+	store->requestCapacity(this, this->mCapacity);
+
+	// clang-format off
+	QObject::connect(store, &NotificationHistoryStore::aboutToPrepend, this, [this]() { this->beginInsertRows(QModelIndex(), 0, 0); });
+	QObject::connect(store, &NotificationHistoryStore::prepended, this, [this]() { this->endInsertRows(); emit this->countChanged(); });
+	QObject::connect(store, &NotificationHistoryStore::aboutToRemoveOldest, this, &NotificationHistory::onAboutToRemoveOldest);
+	QObject::connect(store, &NotificationHistoryStore::removedOldest, this, [this]() { this->endRemoveRows(); emit this->countChanged(); });
+	QObject::connect(store, &NotificationHistoryStore::aboutToReset, this, [this]() { this->beginResetModel(); });
+	QObject::connect(store, &NotificationHistoryStore::reset, this, [this]() { this->endResetModel(); emit this->countChanged(); });
+	// clang-format on
+}
+
+NotificationHistory::~NotificationHistory() {
+	// shrinking the history must not update a model that is being destroyed
+	QObject::disconnect(this->store, nullptr, this, nullptr);
+	this->store->dropCapacityRequest(this);
+}
+
+void NotificationHistory::onAboutToRemoveOldest(qsizetype count) {
+	auto total = static_cast<qint32>(this->store->count());
+	this->beginRemoveRows(QModelIndex(), total - static_cast<qint32>(count), total - 1);
+}
+
+qint32 NotificationHistory::rowCount(const QModelIndex& parent) const {
+	if (parent != QModelIndex()) return 0;
+	return static_cast<qint32>(this->store->count());
+}
+
+QVariant NotificationHistory::data(const QModelIndex& index, qint32 role) const {
+	if (role != 0) return QVariant();
+	return QVariant::fromValue(this->store->entry(index.row()));
+}
+
+QHash<int, QByteArray> NotificationHistory::roleNames() const { return {{0, "modelData"}}; }
+
+NotificationHistoryEntry* NotificationHistory::get(qsizetype index) const {
+	return this->store->entry(index);
+}
+
+void NotificationHistory::clear() { this->store->clear(); }
+
+qsizetype NotificationHistory::capacity() const { return this->mCapacity; }
+
+void NotificationHistory::setCapacity(qsizetype capacity) {
+	capacity = std::max(capacity, static_cast<qsizetype>(0));
+	if (capacity == this->mCapacity) return;
+
+	this->mCapacity = capacity;
+	this->store->requestCapacity(this, capacity);
+	emit this->capacityChanged();
+}
+
+qsizetype NotificationHistory::count() const { return this->store->count(); }
+
+} // namespace qs::service::notifications
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <qabstractitemmodel.h>
+#include <qcontainerfwd.h>
+#include <qdatastream.h>
+#include <qdatetime.h>
+#include <qfile.h>
+#include <qhash.h>
+#include <qobject.h>
+#include <qpointer.h>
+#include <qqmlintegration.h>
+#include <qtclasshelpermacros.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+
+#include "dbusimage.hpp"
+#include "notification.hpp"
+
+namespace qs::service::notifications {
+
+class NotificationHistoryEntry;
+
+// Interned strings with reference counts. Id 0 is always the empty string.
+class HistoryStringPool {
+public:
+	quint32 ref(const QString& string);
+	void unref(quint32 id);
+	[[nodiscard]] const QString& get(quint32 id) const;
+
+private:
+	struct Entry {
+		QString string;
+		quint32 refs = 0;
+	};
+
+	QVector<Entry> entries {Entry()};
+	QVector<quint32> freeEntries;
+	QHash<QString, quint32> ids;
+};
+
+struct HistoryImageKey {
+	qint32 width = 0;
+	qint32 height = 0;
+	qint32 rowstride = 0;
+	bool hasAlpha = false;
+	QByteArray data;
+
+	[[nodiscard]] bool operator==(const HistoryImageKey& other) const = default;
+};
+
+size_t qHash(const HistoryImageKey& key, size_t seed = 0);
+
+// Closed notifications, kept in a columnar ring and persisted to an append-only
+// file in the cache directory. Shared by every NotificationHistory.
+class NotificationHistoryStore: public QObject {
+	Q_OBJECT;
+
+public:
+	static NotificationHistoryStore* instance();
+
+	// Records a closed notification if the history is in use.
+	static void recordClosed(Notification* notification, NotificationCloseReason::Enum reason);
+
+	[[nodiscard]] qsizetype count() const;
+	[[nodiscard]] qsizetype capacity() const;
+	void clear();
+
+	// Every NotificationHistory requests a capacity, and the largest request is used.
+	void requestCapacity(const QObject* requester, qsizetype capacity);
+	void dropCapacityRequest(const QObject* requester);
+
+	// Index 0 is the newest entry. Entries are created on demand and owned by javascript.
+	[[nodiscard]] NotificationHistoryEntry* entry(qsizetype index);
+
+signals:
+	void aboutToPrepend();
+	void prepended();
+	void aboutToRemoveOldest(qsizetype count);
+	void removedOldest();
+	void aboutToReset();
+	void reset();
+
+private:
+	struct Record {
+		qint64 time = 0;
+		QString appName;
+		QString appIcon;
+		QString summary;
+		QString body;
+		QString desktopEntry;
+		QString imagePath;
+		HistoryImageKey image;
+		quint8 urgency = NotificationUrgency::Normal;
+		quint8 closeReason = NotificationCloseReason::Dismissed;
+	};
+
+	struct Image {
+		HistoryImageKey key;
+		quint32 refs = 0;
+		// id of the image's definition in the current history file, 0 if not written yet
+		quint32 fileId = 0;
+		NotificationImage* handle = nullptr;
+	};
+
+	explicit NotificationHistoryStore();
+
+	void setCapacity(qsizetype capacity);
+	void updateCapacity();
+
+	void append(const Record& record, bool persist);
+	void removeOldest(qsizetype count);
+	void releaseSlot(qsizetype slot);
+	[[nodiscard]] qsizetype slotOf(qsizetype index) const;
+	[[nodiscard]] Record recordAt(qsizetype slot) const;
+
+	quint32 refImage(const HistoryImageKey& key);
+	void unrefImage(quint32 id);
+
+	void load();
+	void loadFile(const QString& path);
+	void openFile();
+	void writeRecord(QDataStream& stream, const Record& record, quint32 imageId);
+	void compact();
+
+	// columns, indexed by ring slot
+	QVector<quint64> serials;
+	QVector<qint64> times;
+	QVector<quint32> appNames;
+	QVector<quint32> appIcons;
+	QVector<quint32> summaries;
+	QVector<quint32> bodies;
+	QVector<quint32> desktopEntries;
+	QVector<quint32> imagePaths;
+	QVector<quint32> images;
+	QVector<quint8> urgencies;
+	QVector<quint8> closeReasons;
+
+	qsizetype mCapacity = 0;
+	QHash<const QObject*, qsizetype> capacityRequests;
+	qsizetype oldest = 0;
+	qsizetype mCount = 0;
+	quint64 nextSerial = 1;
+
+	HistoryStringPool strings;
+	QVector<Image> imagePool {Image()};
+	QVector<quint32> freeImages;
+	QHash<HistoryImageKey, quint32> imageIds;
+
+	QHash<quint64, QPointer<NotificationHistoryEntry>> liveEntries;
+
+	QString path;
+	QFile file;
+	QDataStream stream;
+	quint32 nextFileImageId = 1;
+	qsizetype fileEntries = 0;
+
+	friend class TestNotificationHistory;
+};
+
+///! A notification kept by NotificationHistory.
+class NotificationHistoryEntry: public QObject {
+	Q_OBJECT;
+	// clang-format off
+	/// When the notification was received.
+	Q_PROPERTY(QDateTime time MEMBER time CONSTANT);
+	/// See @@Notification.appName.
+	Q_PROPERTY(QString appName MEMBER appName CONSTANT);
+	/// See @@Notification.appIcon.
+	Q_PROPERTY(QString appIcon MEMBER appIcon CONSTANT);
+	/// See @@Notification.summary.
+	Q_PROPERTY(QString summary MEMBER summary CONSTANT);
+	/// See @@Notification.body.
+	Q_PROPERTY(QString body MEMBER body CONSTANT);
+	/// See @@Notification.urgency.
+	Q_PROPERTY(NotificationUrgency::Enum urgency MEMBER urgency CONSTANT);
+	/// See @@Notification.desktopEntry.
+	Q_PROPERTY(QString desktopEntry MEMBER desktopEntry CONSTANT);
+	/// See @@Notification.image.
+	Q_PROPERTY(QString image MEMBER image CONSTANT);
+	/// Why the notification was closed.
+	Q_PROPERTY(NotificationCloseReason::Enum closeReason MEMBER closeReason CONSTANT);
+	// clang-format on
+	QML_ELEMENT;
+	QML_UNCREATABLE("NotificationHistoryEntries must be acquired from a NotificationHistory");
+
+public:
+	explicit NotificationHistoryEntry(QObject* parent = nullptr): QObject(parent) {}
+
+	QDateTime time;
+	QString appName;
+	QString appIcon;
+	QString summary;
+	QString body;
+	NotificationUrgency::Enum urgency = NotificationUrgency::Normal;
+	QString desktopEntry;
+	QString image;
+	NotificationCloseReason::Enum closeReason = NotificationCloseReason::Dismissed;
+};
+
+///! History of closed notifications.
+/// A model of notifications closed by the @@NotificationServer, newest first.
+///
+/// History is kept across reloads and restarts in the cache directory. Notifications
+/// marked @@Notification.transient are not kept. Only notifications closed while a
+/// NotificationHistory exists are recorded.
+///
+/// Entries are exposed through the `modelData` role as @@NotificationHistoryEntry objects,
+/// which are only created for rows a view actually displays.
+///
+/// All NotificationHistory objects share the same history, which keeps
+/// the largest @@capacity requested by any of them.
+///
+/// #### Example
+/// ```qml
+/// ListView {
+///   model: NotificationHistory { capacity: 200 }
+///
+///   delegate: Text {
+///     required property NotificationHistoryEntry modelData
+///     text: `${modelData.appName}: ${modelData.summary}`
+///   }
+/// }
+/// ```
+class NotificationHistory: public QAbstractListModel {
+	Q_OBJECT;
+	/// The maximum number of notifications this object needs kept. Older notifications are
+	/// discarded once the history is full. Defaults to 100.
+	///
+	/// The shared history keeps as many notifications as the largest capacity requested by
+	/// a NotificationHistory, so @@count may exceed the capacity of this object.
+	Q_PROPERTY(qsizetype capacity READ capacity WRITE setCapacity NOTIFY capacityChanged);
+	/// The number of notifications in the history.
+	Q_PROPERTY(qsizetype count READ count NOTIFY countChanged);
+	QML_ELEMENT;
+
+public:
+	explicit NotificationHistory(QObject* parent = nullptr);
+	~NotificationHistory() override;
+	Q_DISABLE_COPY_MOVE(NotificationHistory);
+
+	[[nodiscard]] qint32 rowCount(const QModelIndex& parent) const override;
+	[[nodiscard]] QVariant data(const QModelIndex& index, qint32 role) const override;
+	[[nodiscard]] QHash<int, QByteArray> roleNames() const override;
+
+	/// Returns the entry at the given index, where 0 is the newest notification.
+	Q_INVOKABLE [[nodiscard]] qs::service::notifications::NotificationHistoryEntry*
+	get(qsizetype index) const;
+
+	/// Removes every notification from the history.
+	Q_INVOKABLE void clear();
+
+	[[nodiscard]] qsizetype capacity() const;
+	void setCapacity(qsizetype capacity);
+
+	[[nodiscard]] qsizetype count() const;
+
+signals:
+	void capacityChanged();
+	void countChanged();
+
+private slots:
+	void onAboutToRemoveOldest(qsizetype count);
+
+private:
+	NotificationHistoryStore* store;
+	qsizetype mCapacity;
+};
+
+} // namespace qs::service::notifications
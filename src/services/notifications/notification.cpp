@@ -36,6 +36,15 @@ QString NotificationCloseReason::toString(NotificationCloseReason::Enum value) {
 	}
 }
 
+QString NotificationRateLimitPolicy::toString(NotificationRateLimitPolicy::Enum value) {
+	switch (value) {
+	case NotificationRateLimitPolicy::Drop: return "Drop";
+	case NotificationRateLimitPolicy::Merge: return "Merge";
+	case NotificationRateLimitPolicy::Queue: return "Queue";
+	default: return "Invalid notification rate limit policy";
+	}
+}
+
 QString NotificationAction::identifier() const { return this->mIdentifier; }
 QString NotificationAction::text() const { return this->mText; }
 
@@ -3,6 +3,7 @@
 #include <utility>
 
 #include <qcontainerfwd.h>
+#include <qdatetime.h>
 #include <qmap.h>
 #include <qobject.h>
 #include <qqmlintegration.h>
@@ -14,6 +15,7 @@
 namespace qs::service::notifications {
 
 class NotificationImage;
+class NotificationHistoryStore;
 
 ///! The urgency level of a Notification.
 /// See @@Notification.urgency.
@@ -54,6 +56,33 @@ public:
 	Q_INVOKABLE static QString toString(NotificationCloseReason::Enum value);
 };
 
+///! How a NotificationServer handles notifications over its rate limit.
+/// See @@NotificationServer.rateLimitPolicy.
+class NotificationRateLimitPolicy: public QObject {
+	Q_OBJECT;
+	QML_ELEMENT;
+	QML_SINGLETON;
+
+public:
+	enum Enum {
+		/// Notifications over the limit are discarded and reported to the sender as expired.
+		Drop = 0,
+		/// Notifications over the limit replace the application's most recent notification.
+		///
+		/// The number of notifications merged into it is available as the `x-quickshell-merged`
+		/// entry of @@Notification.hints. If the application has no tracked notification,
+		/// the notification is dropped.
+		Merge = 1,
+		/// Notifications over the limit are held back and delivered as the limit allows.
+		///
+		/// At most 64 notifications are queued per application. Further notifications are dropped.
+		Queue = 2,
+	};
+	Q_ENUM(Enum);
+
+	Q_INVOKABLE static QString toString(NotificationRateLimitPolicy::Enum value);
+};
+
 class NotificationAction;
 
 ///! A notification emitted by a NotificationServer.
@@ -182,6 +211,7 @@ private:
 	NotificationImage* mImagePixmap = nullptr;
 	QString mDesktopEntry;
 	QVariantMap mHints;
+	QDateTime receivedTime = QDateTime::currentDateTime();
 
 	// clang-format off
 	DECLARE_PRIVATE_MEMBER(Notification, expireTimeout, setExpireTimeout, mExpireTimeout, expireTimeoutChanged);
@@ -197,6 +227,8 @@ private:
 	DECLARE_PRIVATE_MEMBER(Notification, desktopEntry, setDesktopEntry, mDesktopEntry, desktopEntryChanged);
 	DECLARE_PRIVATE_MEMBER(Notification, hints, setHints, mHints, hintsChanged);
 	// clang-format on
+
+	friend class NotificationHistoryStore;
 };
 
 ///! An action associated with a Notification.
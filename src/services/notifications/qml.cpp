@@ -5,6 +5,7 @@
 #include <qlogging.h>
 #include <qobject.h>
 #include <qtmetamacros.h>
+#include <qtypes.h>
 
 #include "../../core/model.hpp"
 #include "notification.hpp"
@@ -15,6 +16,7 @@ namespace qs::service::notifications {
 void NotificationServerQml::onPostReload() {
 	auto* instance = NotificationServer::instance();
 	instance->support = this->support;
+	instance->setRateLimit(this->rateLimit);
 
 	QObject::connect(
 	    instance,
@@ -23,9 +25,17 @@ void NotificationServerQml::onPostReload() {
 	    &NotificationServerQml::notification
 	);
 
+	QObject::connect(
+	    instance,
+	    &NotificationServer::rateLimitCountersChanged,
+	    this,
+	    &NotificationServerQml::rateLimitCountersChanged
+	);
+
 	instance->switchGeneration(this->mKeepOnReload, [this]() {
 		this->live = true;
 		emit this->trackedNotificationsChanged();
+		emit this->rateLimitCountersChanged();
 	});
 }
 
@@ -124,6 +134,47 @@ void NotificationServerQml::setExtraHints(QVector<QString> extraHints) {
 	emit this->extraHintsChanged();
 }
 
+qint32 NotificationServerQml::rateLimitBurst() const { return this->rateLimit.burst; }
+
+void NotificationServerQml::setRateLimitBurst(qint32 rateLimitBurst) {
+	if (rateLimitBurst == this->rateLimit.burst) return;
+	this->rateLimit.burst = rateLimitBurst;
+	this->updateRateLimit();
+	emit this->rateLimitBurstChanged();
+}
+
+qreal NotificationServerQml::rateLimitRate() const { return this->rateLimit.rate; }
+
+void NotificationServerQml::setRateLimitRate(qreal rateLimitRate) {
+	if (rateLimitRate == this->rateLimit.rate) return;
+	this->rateLimit.rate = rateLimitRate;
+	this->updateRateLimit();
+	emit this->rateLimitRateChanged();
+}
+
+NotificationRateLimitPolicy::Enum NotificationServerQml::rateLimitPolicy() const {
+	return this->rateLimit.policy;
+}
+
+void NotificationServerQml::setRateLimitPolicy(NotificationRateLimitPolicy::Enum rateLimitPolicy) {
+	if (rateLimitPolicy == this->rateLimit.policy) return;
+	this->rateLimit.policy = rateLimitPolicy;
+	this->updateRateLimit();
+	emit this->rateLimitPolicyChanged();
+}
+
+quint64 NotificationServerQml::droppedNotifications() const {
+	return this->live ? NotificationServer::instance()->droppedCount() : 0;
+}
+
+quint64 NotificationServerQml::mergedNotifications() const {
+	return this->live ? NotificationServer::instance()->mergedCount() : 0;
+}
+
+quint64 NotificationServerQml::queuedNotifications() const {
+	return this->live ? NotificationServer::instance()->queuedCount() : 0;
+}
+
 ObjectModel<Notification>* NotificationServerQml::trackedNotifications() const {
 	if (this->live) {
 		return NotificationServer::instance()->trackedNotifications();
@@ -138,4 +189,10 @@ void NotificationServerQml::updateSupported() {
 	}
 }
 
+void NotificationServerQml::updateRateLimit() {
+	if (this->live) {
+		NotificationServer::instance()->setRateLimit(this->rateLimit);
+	}
+}
+
 } // namespace qs::service::notifications
@@ -5,6 +5,7 @@
 #include <qobject.h>
 #include <qqmlintegration.h>
 #include <qtmetamacros.h>
+#include <qtypes.h>
 
 #include "../../core/model.hpp"
 #include "../../core/reload.hpp"
@@ -70,6 +71,28 @@ class NotificationServerQml
 	Q_PROPERTY(ObjectModel<Notification>* trackedNotifications READ trackedNotifications NOTIFY trackedNotificationsChanged);
 	/// Extra hints to expose to notification clients.
 	Q_PROPERTY(QVector<QString> extraHints READ extraHints WRITE setExtraHints NOTIFY extraHintsChanged);
+	/// The number of new notifications an application may send in quick succession before
+	/// being rate limited. Defaults to 0, which disables rate limiting.
+	///
+	/// Each application has its own limit, which recovers at @@rateLimitRate.
+	/// Notifications replacing an existing notification and critical notifications
+	/// are never limited.
+	Q_PROPERTY(qint32 rateLimitBurst READ rateLimitBurst WRITE setRateLimitBurst NOTIFY rateLimitBurstChanged);
+	/// The number of notifications per second an application regains once it has hit
+	/// @@rateLimitBurst. Defaults to 2.
+	///
+	/// A rate of 0 means an application never regains notifications once it has hit
+	/// @@rateLimitBurst, and the `Queue` policy drops notifications over the limit instead of
+	/// queuing them, as they could never be delivered. Negative rates are treated as 0.
+	Q_PROPERTY(qreal rateLimitRate READ rateLimitRate WRITE setRateLimitRate NOTIFY rateLimitRateChanged);
+	/// What happens to notifications over the rate limit. Defaults to `Drop`.
+	Q_PROPERTY(NotificationRateLimitPolicy::Enum rateLimitPolicy READ rateLimitPolicy WRITE setRateLimitPolicy NOTIFY rateLimitPolicyChanged);
+	/// The number of notifications discarded by the rate limit.
+	Q_PROPERTY(quint64 droppedNotifications READ droppedNotifications NOTIFY rateLimitCountersChanged);
+	/// The number of notifications merged into an earlier notification by the rate limit.
+	Q_PROPERTY(quint64 mergedNotifications READ mergedNotifications NOTIFY rateLimitCountersChanged);
+	/// The number of notifications held back by the rate limit.
+	Q_PROPERTY(quint64 queuedNotifications READ queuedNotifications NOTIFY rateLimitCountersChanged);
 	// clang-format on
 	QML_NAMED_ELEMENT(NotificationServer);
 
@@ -106,6 +129,19 @@ public:
 	[[nodiscard]] QVector<QString> extraHints() const;
 	void setExtraHints(QVector<QString> extraHints);
 
+	[[nodiscard]] qint32 rateLimitBurst() const;
+	void setRateLimitBurst(qint32 rateLimitBurst);
+
+	[[nodiscard]] qreal rateLimitRate() const;
+	void setRateLimitRate(qreal rateLimitRate);
+
+	[[nodiscard]] NotificationRateLimitPolicy::Enum rateLimitPolicy() const;
+	void setRateLimitPolicy(NotificationRateLimitPolicy::Enum rateLimitPolicy);
+
+	[[nodiscard]] quint64 droppedNotifications() const;
+	[[nodiscard]] quint64 mergedNotifications() const;
+	[[nodiscard]] quint64 queuedNotifications() const;
+
 	[[nodiscard]] ObjectModel<Notification>* trackedNotifications() const;
 
 signals:
@@ -124,14 +160,20 @@ signals:
 	void actionIconsSupportedChanged();
 	void imageSupportedChanged();
 	void extraHintsChanged();
+	void rateLimitBurstChanged();
+	void rateLimitRateChanged();
+	void rateLimitPolicyChanged();
+	void rateLimitCountersChanged();
 	void trackedNotificationsChanged();
 
 private:
 	void updateSupported();
+	void updateRateLimit();
 
 	bool live = false;
 	bool mKeepOnReload = true;
 	NotificationServerSupport support;
+	NotificationRateLimit rateLimit;
 };
 
 } // namespace qs::service::notifications
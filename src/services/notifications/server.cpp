@@ -1,5 +1,7 @@
 #include "server.hpp"
+#include <algorithm>
 #include <functional>
+#include <utility>
 
 #include <qcontainerfwd.h>
 #include <qcoreapplication.h>
@@ -8,6 +10,8 @@
 #include <qdbusservicewatcher.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
+#include <qnamespace.h>
+#include <qobject.h>
 #include <qqmlengine.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
@@ -15,15 +19,36 @@
 #include "../../core/model.hpp"
 #include "dbus_notifications.h"
 #include "dbusimage.hpp"
+#include "history.hpp"
 #include "notification.hpp"
 
 namespace qs::service::notifications {
 
 Q_LOGGING_CATEGORY(logNotifications, "quickshell.service.notifications");
 
+namespace {
+
+// Per app limit for the queue policy. Notifications past it are dropped.
+constexpr qsizetype MAX_QUEUED_NOTIFICATIONS = 64;
+// Buckets of apps with a full bucket and nothing queued are forgotten past this many apps.
+constexpr qsizetype BUCKET_SWEEP_THRESHOLD = 64;
+constexpr qint32 MIN_DRAIN_INTERVAL = 16;
+constexpr qint32 MAX_DRAIN_INTERVAL = 1000;
+
+} // namespace
+
 NotificationServer::NotificationServer() {
 	qDBusRegisterMetaType<DBusNotificationImage>();
 
+	this->rateLimitClock.start();
+
+	QObject::connect(
+	    &this->drainTimer,
+	    &QTimer::timeout,
+	    this,
+	    &NotificationServer::onDrainTimeout
+	);
+
 	new DBusNotificationServer(this);
 
 	qCInfo(logNotifications) << "Starting notification server";
@@ -105,6 +130,7 @@ void NotificationServer::deleteNotification(
 	this->idMap.remove(notification->id());
 
 	emit this->NotificationClosed(notification->id(), reason);
+	NotificationHistoryStore::recordClosed(notification, reason);
 	notification->retainedDestroy();
 }
 
@@ -132,6 +158,18 @@ void NotificationServer::CloseNotification(uint id) {
 
 	if (notification) {
 		this->deleteNotification(notification, NotificationCloseReason::CloseRequested);
+		return;
+	}
+
+	for (auto& bucket: this->buckets) {
+		auto removed = bucket.queue.removeIf([&](const PendingNotification& pending) {
+			return pending.id == id;
+		});
+
+		if (removed != 0) {
+			emit this->NotificationClosed(id, NotificationCloseReason::CloseRequested);
+			return;
+		}
 	}
 }
 
@@ -177,29 +215,277 @@ uint NotificationServer::Notify(
     const QVariantMap& hints,
     int expireTimeout
 ) {
-	auto* notification = replacesId == 0 ? nullptr : this->idMap.value(replacesId);
-	auto old = notification != nullptr;
+	if (replacesId != 0) {
+		if (auto* notification = this->idMap.value(replacesId)) {
+			notification->updateProperties(
+			    appName,
+			    appIcon,
+			    summary,
+			    body,
+			    actions,
+			    hints,
+			    expireTimeout
+			);
+			return notification->id();
+		}
 
-	if (!notification) {
-		notification = new Notification(this->nextId++, this);
-		QQmlEngine::setObjectOwnership(notification, QQmlEngine::CppOwnership);
+		// replacing a queued notification keeps its place in the queue
+		if (auto* pending = this->findQueued(replacesId)) {
+			*pending = PendingNotification {
+			    .id = pending->id,
+			    .appName = appName,
+			    .appIcon = appIcon,
+			    .summary = summary,
+			    .body = body,
+			    .actions = actions,
+			    .hints = hints,
+			    .expireTimeout = expireTimeout,
+			};
+
+			return replacesId;
+		}
 	}
 
-	notification->updateProperties(appName, appIcon, summary, body, actions, hints, expireTimeout);
+	auto pending = PendingNotification {
+	    .id = this->nextId++,
+	    .appName = appName,
+	    .appIcon = appIcon,
+	    .summary = summary,
+	    .body = body,
+	    .actions = actions,
+	    .hints = hints,
+	    .expireTimeout = expireTimeout,
+	};
 
-	if (!old) {
-		emit this->notification(notification);
+	RateLimitBucket* bucket = nullptr;
 
-		if (!notification->isTracked()) {
-			emit this->NotificationClosed(notification->id(), notification->closeReason());
-			delete notification;
-		} else {
-			this->idMap.insert(notification->id(), notification);
-			this->mNotifications.insertObject(notification);
+	// critical notifications are never held back
+	auto critical = hints.value("urgency").value<quint8>() == NotificationUrgency::Critical;
+
+	if (this->rateLimit.burst > 0 && !critical) {
+		if (this->buckets.size() > BUCKET_SWEEP_THRESHOLD) this->sweepBuckets();
+
+		auto isNew = !this->buckets.contains(appName);
+		bucket = &this->buckets[appName];
+
+		if (isNew) {
+			bucket->tokens = this->rateLimit.burst;
+			bucket->lastRefill = this->rateLimitClock.elapsed();
+		}
+
+		if (!this->takeToken(*bucket)) {
+			return this->limitNotification(*bucket, std::move(pending));
+		}
+	}
+
+	auto* notification = this->createNotification(pending);
+
+	if (notification) {
+		this->idMap.insert(notification->id(), notification);
+		this->mNotifications.insertObject(notification);
+		if (bucket) bucket->lastId = notification->id();
+	}
+
+	return pending.id;
+}
+
+Notification* NotificationServer::createNotification(const PendingNotification& pending) {
+	auto* notification = new Notification(pending.id, this);
+	QQmlEngine::setObjectOwnership(notification, QQmlEngine::CppOwnership);
+
+	notification->updateProperties(
+	    pending.appName,
+	    pending.appIcon,
+	    pending.summary,
+	    pending.body,
+	    pending.actions,
+	    pending.hints,
+	    pending.expireTimeout
+	);
+
+	emit this->notification(notification);
+
+	if (!notification->isTracked()) {
+		emit this->NotificationClosed(notification->id(), notification->closeReason());
+		delete notification;
+		return nullptr;
+	}
+
+	return notification;
+}
+
+void NotificationServer::refill(RateLimitBucket& bucket, qint64 now) const {
+	auto elapsed = static_cast<qreal>(now - bucket.lastRefill) / 1000.0;
+	bucket.tokens = std::min(
+	    static_cast<qreal>(this->rateLimit.burst),
+	    bucket.tokens + elapsed * this->rateLimit.rate
+	);
+	bucket.lastRefill = now;
+}
+
+bool NotificationServer::takeToken(RateLimitBucket& bucket) {
+	this->refill(bucket, this->rateLimitClock.elapsed());
+
+	// anything sent while older notifications are queued has to wait behind them
+	if (!bucket.queue.isEmpty() || bucket.tokens < 1) return false;
+
+	bucket.tokens -= 1;
+	return true;
+}
+
+void NotificationServer::sweepBuckets() {
+	auto now = this->rateLimitClock.elapsed();
+
+	this->buckets.removeIf([&](const auto& entry) {
+		auto& bucket = entry.value();
+		if (!bucket.queue.isEmpty()) return false;
+
+		this->refill(bucket, now);
+		return bucket.tokens >= this->rateLimit.burst;
+	});
+}
+
+uint NotificationServer::limitNotification(RateLimitBucket& bucket, PendingNotification pending) {
+	switch (this->rateLimit.policy) {
+	case NotificationRateLimitPolicy::Merge:
+		if (auto* notification = this->idMap.value(bucket.lastId)) {
+			auto merged = notification->hints().value("x-quickshell-merged").value<qint32>() + 1;
+			pending.hints.insert("x-quickshell-merged", merged);
+
+			notification->updateProperties(
+			    pending.appName,
+			    pending.appIcon,
+			    pending.summary,
+			    pending.body,
+			    pending.actions,
+			    pending.hints,
+			    pending.expireTimeout
+			);
+
+			this->mMergedCount++;
+			emit this->rateLimitCountersChanged();
+			return notification->id();
+		}
+		break;
+	case NotificationRateLimitPolicy::Queue:
+		// without a rate the queue would never drain
+		if (this->rateLimit.rate > 0 && bucket.queue.length() < MAX_QUEUED_NOTIFICATIONS) {
+			auto id = pending.id;
+			bucket.queue.append(std::move(pending));
+			this->startDrain();
+
+			this->mQueuedCount++;
+			emit this->rateLimitCountersChanged();
+			return id;
+		}
+		break;
+	default: break;
+	}
+
+	this->dropNotification(pending.id);
+	return pending.id;
+}
+
+void NotificationServer::dropNotification(quint32 id) {
+	this->mDroppedCount++;
+	emit this->rateLimitCountersChanged();
+
+	// the sender has not received the id yet, so close it after the reply is sent
+	QMetaObject::invokeMethod(
+	    this,
+	    [this, id]() { emit this->NotificationClosed(id, NotificationCloseReason::Expired); },
+	    Qt::QueuedConnection
+	);
+}
+
+NotificationServer::PendingNotification* NotificationServer::findQueued(quint32 id) {
+	for (auto& bucket: this->buckets) {
+		for (auto& pending: bucket.queue) {
+			if (pending.id == id) return &pending;
+		}
+	}
+
+	return nullptr;
+}
+
+void NotificationServer::startDrain() {
+	if (this->drainTimer.isActive()) return;
+
+	auto interval = this->rateLimit.rate > 0 ? 1000.0 / this->rateLimit.rate : MAX_DRAIN_INTERVAL;
+	this->drainTimer.start(
+	    std::clamp(static_cast<qint32>(interval), MIN_DRAIN_INTERVAL, MAX_DRAIN_INTERVAL)
+	);
+}
+
+void NotificationServer::onDrainTimeout() {
+	auto now = this->rateLimitClock.elapsed();
+	auto unlimited = this->rateLimit.burst <= 0;
+	auto delivered = QVector<quint32>();
+	auto waiting = false;
+
+	for (auto& bucket: this->buckets) {
+		if (bucket.queue.isEmpty()) continue;
+
+		if (!unlimited) this->refill(bucket, now);
+
+		while (!bucket.queue.isEmpty() && (unlimited || bucket.tokens >= 1)) {
+			if (!unlimited) bucket.tokens -= 1;
+
+			auto pending = bucket.queue.takeFirst();
+
+			if (auto* notification = this->createNotification(pending)) {
+				this->idMap.insert(notification->id(), notification);
+				delivered.push_back(notification->id());
+				bucket.lastId = notification->id();
+			}
 		}
+
+		if (!bucket.queue.isEmpty()) waiting = true;
+	}
+
+	if (!waiting) this->drainTimer.stop();
+	if (unlimited) this->buckets.clear();
+
+	// Insert everything delivered this tick at once. Handlers for later notifications
+	// may have already closed earlier ones, which removes them from the id map.
+	auto notifications = QVector<Notification*>();
+	notifications.reserve(delivered.length());
+
+	for (auto id: delivered) {
+		if (auto* notification = this->idMap.value(id)) notifications.push_back(notification);
 	}
 
-	return notification->id();
+	this->mNotifications.insertObjects(notifications);
 }
 
+void NotificationServer::setRateLimit(const NotificationRateLimit& rateLimit) {
+	auto rateChanged = rateLimit.rate != this->rateLimit.rate;
+	this->rateLimit = rateLimit;
+	this->rateLimit.rate = std::max(this->rateLimit.rate, 0.0);
+
+	// without a rate anything still queued would never be delivered
+	if (this->rateLimit.burst > 0 && this->rateLimit.rate == 0) {
+		for (auto& bucket: this->buckets) {
+			for (const auto& pending: bucket.queue) {
+				this->dropNotification(pending.id);
+			}
+
+			bucket.queue.clear();
+		}
+
+		this->drainTimer.stop();
+		return;
+	}
+
+	// if limiting was disabled, anything still queued is flushed on the next tick
+	if (rateChanged && this->drainTimer.isActive()) {
+		this->drainTimer.stop();
+		this->startDrain();
+	}
+}
+
+quint64 NotificationServer::droppedCount() const { return this->mDroppedCount; }
+quint64 NotificationServer::mergedCount() const { return this->mMergedCount; }
+quint64 NotificationServer::queuedCount() const { return this->mQueuedCount; }
+
 } // namespace qs::service::notifications
@@ -4,10 +4,16 @@
 
 #include <qcontainerfwd.h>
 #include <qdbusservicewatcher.h>
+#include <qelapsedtimer.h>
 #include <qhash.h>
+#include <qlist.h>
 #include <qobject.h>
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qtimer.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
+#include <qvariant.h>
 
 #include "../../core/model.hpp"
 #include "notification.hpp"
@@ -26,6 +32,14 @@ struct NotificationServerSupport {
 	QVector<QString> extraHints;
 };
 
+struct NotificationRateLimit {
+	// notifications an app may send at once, 0 disables rate limiting
+	qint32 burst = 0;
+	// notifications per second an app regains after its burst is spent, 0 never regains any
+	qreal rate = 2;
+	NotificationRateLimitPolicy::Enum policy = NotificationRateLimitPolicy::Drop;
+};
+
 class NotificationServer: public QObject {
 	Q_OBJECT;
 
@@ -52,10 +66,17 @@ public:
 	);
 	// NOLINTEND
 
+	void setRateLimit(const NotificationRateLimit& rateLimit);
+
+	[[nodiscard]] quint64 droppedCount() const;
+	[[nodiscard]] quint64 mergedCount() const;
+	[[nodiscard]] quint64 queuedCount() const;
+
 	NotificationServerSupport support;
 
 signals:
 	void notification(Notification* notification);
+	void rateLimitCountersChanged();
 
 	// NOLINTBEGIN
 	void NotificationClosed(quint32 id, quint32 reason);
@@ -64,16 +85,54 @@ signals:
 
 private slots:
 	void onServiceUnregistered(const QString& service);
+	void onDrainTimeout();
 
 private:
+	struct PendingNotification {
+		quint32 id = 0;
+		QString appName;
+		QString appIcon;
+		QString summary;
+		QString body;
+		QStringList actions;
+		QVariantMap hints;
+		qint32 expireTimeout = 0;
+	};
+
+	struct RateLimitBucket {
+		qreal tokens = 0;
+		qint64 lastRefill = 0;
+		// most recent notification delivered for the app, used by the merge policy
+		quint32 lastId = 0;
+		QList<PendingNotification> queue;
+	};
+
 	explicit NotificationServer();
 
 	static void tryRegister();
 
+	// Creates and emits a new notification. Returns nullptr if it was not tracked.
+	Notification* createNotification(const PendingNotification& pending);
+	bool takeToken(RateLimitBucket& bucket);
+	void refill(RateLimitBucket& bucket, qint64 now) const;
+	void sweepBuckets();
+	uint limitNotification(RateLimitBucket& bucket, PendingNotification pending);
+	void dropNotification(quint32 id);
+	PendingNotification* findQueued(quint32 id);
+	void startDrain();
+
 	QDBusServiceWatcher serviceWatcher;
 	quint32 nextId = 1;
 	QHash<quint32, Notification*> idMap;
 	ObjectModel<Notification> mNotifications {this};
+
+	NotificationRateLimit rateLimit;
+	QHash<QString, RateLimitBucket> buckets;
+	QElapsedTimer rateLimitClock;
+	QTimer drainTimer;
+	quint64 mDroppedCount = 0;
+	quint64 mMergedCount = 0;
+	quint64 mQueuedCount = 0;
 };
 
 } // namespace qs::service::notifications
@@ -0,0 +1,250 @@
+#include "history.hpp"
+
+#include <qbytearray.h>
+#include <qcontainerfwd.h>
+#include <qfile.h>
+#include <qlist.h>
+#include <qlogging.h>
+#include <qobject.h>
+#include <qregularexpression.h>
+#include <qstring.h>
+#include <qtemporarydir.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qtypes.h>
+
+#include "../history.hpp"
+
+namespace qs::service::notifications {
+
+void TestNotificationHistory::append(
+    NotificationHistoryStore& store,
+    const QString& summary,
+    const QByteArray& image,
+    bool persist
+) {
+	auto record = NotificationHistoryStore::Record {
+	    .time = summary.toLongLong(),
+	    .appName = "app",
+	    .summary = summary,
+	};
+
+	if (!image.isEmpty()) {
+		record.image = HistoryImageKey {
+		    .width = 1,
+		    .height = 1,
+		    .rowstride = 4,
+		    .hasAlpha = false,
+		    .data = image,
+		};
+	}
+
+	store.append(record, persist);
+}
+
+QList<QString> TestNotificationHistory::summaries(const NotificationHistoryStore& store) {
+	auto summaries = QList<QString>();
+
+	for (qsizetype i = 0; i != store.count(); i++) {
+		summaries.push_back(store.recordAt(store.slotOf(i)).summary);
+	}
+
+	return summaries;
+}
+
+void TestNotificationHistory::strings() {
+	auto pool = HistoryStringPool();
+	QCOMPARE(pool.ref(""), 0u);
+
+	auto a = pool.ref("a");
+	auto b = pool.ref("b");
+	QVERIFY(a != 0 && b != 0 && a != b);
+	QCOMPARE(pool.ref("a"), a);
+
+	pool.unref(a);
+	QCOMPARE(pool.get(a), "a");
+
+	pool.unref(a);
+	QCOMPARE(pool.get(a), "");
+
+	// freed ids are reused, and unrelated strings are untouched
+	QCOMPARE(pool.ref("c"), a);
+	QCOMPARE(pool.get(a), "c");
+	QCOMPARE(pool.get(b), "b");
+}
+
+void TestNotificationHistory::ring() {
+	auto store = NotificationHistoryStore();
+	store.setCapacity(4);
+
+	for (auto i = 0; i != 6; i++) append(store, QString::number(i));
+	QCOMPARE(store.count(), 4);
+	QCOMPARE(summaries(store), QList<QString>({"5", "4", "3", "2"}));
+
+	// the ring has wrapped, resizing must keep the order
+	store.setCapacity(6);
+	QCOMPARE(summaries(store), QList<QString>({"5", "4", "3", "2"}));
+
+	append(store, "6");
+	append(store, "7");
+	QCOMPARE(summaries(store), QList<QString>({"7", "6", "5", "4", "3", "2"}));
+
+	store.setCapacity(3);
+	QCOMPARE(summaries(store), QList<QString>({"7", "6", "5"}));
+
+	append(store, "8");
+	QCOMPARE(summaries(store), QList<QString>({"8", "7", "6"}));
+
+	store.setCapacity(0);
+	append(store, "9");
+	QCOMPARE(store.count(), 0);
+
+	store.setCapacity(2);
+	append(store, "10");
+	QCOMPARE(summaries(store), QList<QString>({"10"}));
+}
+
+void TestNotificationHistory::images() {
+	auto store = NotificationHistoryStore();
+	store.setCapacity(3);
+
+	append(store, "0", "image-a");
+	append(store, "1", "image-a");
+	append(store, "2", "image-b");
+	QCOMPARE(store.imageIds.size(), 2);
+
+	auto shared = store.images.at(store.slotOf(2));
+	QVERIFY(shared != 0);
+	QCOMPARE(store.images.at(store.slotOf(1)), shared);
+	QCOMPARE(store.imagePool.at(shared).refs, 2u);
+
+	append(store, "3");
+	QCOMPARE(store.imagePool.at(shared).refs, 1u);
+
+	append(store, "4");
+	QCOMPARE(store.imageIds.size(), 1);
+	QCOMPARE(store.freeImages, QList<quint32>({shared}));
+
+	// evicts image-b, then reuses a freed pool slot for image-c
+	append(store, "5", "image-c");
+	QCOMPARE(store.imageIds.size(), 1);
+	QCOMPARE(store.freeImages.length(), 1);
+	QCOMPARE(store.imagePool.length(), 3);
+}
+
+void TestNotificationHistory::capacityRequests() {
+	auto store = NotificationHistoryStore();
+	auto a = QObject();
+	auto b = QObject();
+
+	store.requestCapacity(&a, 5);
+	store.requestCapacity(&b, 2);
+	QCOMPARE(store.capacity(), 5);
+
+	for (auto i = 0; i != 4; i++) append(store, QString::number(i));
+	QCOMPARE(store.count(), 4);
+
+	store.dropCapacityRequest(&a);
+	QCOMPARE(store.capacity(), 2);
+	QCOMPARE(summaries(store), QList<QString>({"3", "2"}));
+
+	// the history is kept as is without any requests
+	store.dropCapacityRequest(&b);
+	QCOMPARE(store.capacity(), 2);
+	QCOMPARE(store.count(), 2);
+}
+
+void TestNotificationHistory::persist() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("history");
+
+	{
+		auto store = NotificationHistoryStore();
+		store.loadFile(path);
+
+		append(store, "0", "image", true);
+		append(store, "1", "image", true);
+		append(store, "2", QByteArray(), true);
+	}
+
+	{
+		auto store = NotificationHistoryStore();
+		store.loadFile(path);
+
+		QCOMPARE(summaries(store), QList<QString>({"2", "1", "0"}));
+		QCOMPARE(store.recordAt(store.slotOf(0)).time, 2);
+		QCOMPARE(store.recordAt(store.slotOf(1)).image.data, "image");
+		QCOMPARE(store.recordAt(store.slotOf(1)).image.rowstride, 4);
+		QCOMPARE(store.imageIds.size(), 1);
+
+		// appended to the existing file
+		append(store, "3", "image", true);
+	}
+
+	auto store = NotificationHistoryStore();
+	store.loadFile(path);
+	QCOMPARE(summaries(store), QList<QString>({"3", "2", "1", "0"}));
+	QCOMPARE(store.imagePool.at(store.images.at(store.slotOf(0))).refs, 3u);
+}
+
+void TestNotificationHistory::truncated() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("history");
+
+	{
+		auto store = NotificationHistoryStore();
+		store.loadFile(path);
+
+		for (auto i = 0; i != 3; i++) append(store, QString::number(i), QByteArray(), true);
+	}
+
+	// cut the last record short, as a crash while writing would
+	auto file = QFile(path);
+	QVERIFY(file.resize(file.size() - 2));
+
+	{
+		QTest::ignoreMessage(QtWarningMsg, QRegularExpression("damaged"));
+
+		auto store = NotificationHistoryStore();
+		store.loadFile(path);
+		QCOMPARE(summaries(store), QList<QString>({"1", "0"}));
+	}
+
+	// the readable entries were rewritten
+	auto store = NotificationHistoryStore();
+	store.loadFile(path);
+	QCOMPARE(summaries(store), QList<QString>({"1", "0"}));
+	QCOMPARE(store.fileEntries, 2);
+}
+
+void TestNotificationHistory::compaction() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("history");
+
+	{
+		auto store = NotificationHistoryStore();
+		store.setCapacity(2);
+		store.loadFile(path);
+
+		for (auto i = 0; i != 100; i++) append(store, QString::number(i), "image", true);
+
+		// evicted entries are dropped from the file once it grows far beyond the history
+		QVERIFY(store.fileEntries < 100);
+	}
+
+	auto store = NotificationHistoryStore();
+	store.setCapacity(2);
+	store.loadFile(path);
+
+	QCOMPARE(summaries(store), QList<QString>({"99", "98"}));
+	QVERIFY(store.fileEntries < 100);
+	QCOMPARE(store.imageIds.size(), 1);
+	QCOMPARE(store.imagePool.at(store.images.at(store.slotOf(0))).refs, 2u);
+}
+
+} // namespace qs::service::notifications
+
+QTEST_GUILESS_MAIN(qs::service::notifications::TestNotificationHistory);
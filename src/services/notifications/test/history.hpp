@@ -0,0 +1,37 @@
+#pragma once
+
+#include <qbytearray.h>
+#include <qcontainerfwd.h>
+#include <qobject.h>
+#include <qstring.h>
+#include <qtmetamacros.h>
+
+#include "../history.hpp"
+
+namespace qs::service::notifications {
+
+class TestNotificationHistory: public QObject {
+	Q_OBJECT;
+
+private slots:
+	static void strings();
+	static void ring();
+	static void images();
+	static void capacityRequests();
+	static void persist();
+	static void truncated();
+	static void compaction();
+
+private:
+	static void append(
+	    NotificationHistoryStore& store,
+	    const QString& summary,
+	    const QByteArray& image = QByteArray(),
+	    bool persist = false
+	);
+
+	// newest first
+	static QList<QString> summaries(const NotificationHistoryStore& store);
+};
+
+} // namespace qs::service::notifications
@@ -0,0 +1,306 @@
+#include "capture.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+
+#include <pipewire/context.h>
+#include <pipewire/core.h>
+#include <pipewire/keys.h>
+#include <pipewire/pipewire.h>
+#include <pipewire/properties.h>
+#include <pipewire/stream.h>
+#include <pipewire/thread-loop.h>
+#include <qbytearray.h>
+#include <qlogging.h>
+#include <qloggingcategory.h>
+#include <qobject.h>
+#include <qstring.h>
+#include <qtimer.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+#include <spa/buffer/buffer.h>
+#include <spa/param/audio/format-utils.h>
+#include <spa/param/audio/raw.h>
+#include <spa/param/param.h>
+#include <spa/pod/builder.h>
+#include <spa/pod/pod.h>
+
+#include "core.hpp"
+#include "qml.hpp"
+
+namespace qs::service::pipewire {
+
+Q_LOGGING_CATEGORY(logCapture, "quickshell.service.pipewire.capture", QtWarningMsg);
+
+namespace {
+
+// Results are cleared if no audio has been captured for this long, which happens
+// when the node is suspended or stops producing audio.
+constexpr qint32 STALE_RESULT_MSECS = 250;
+
+} // namespace
+
+PwCaptureLoop::PwCaptureLoop() {
+	qCInfo(logCapture) << "Creating pipewire capture thread.";
+	pw_init(nullptr, nullptr);
+
+	this->loop = pw_thread_loop_new("qs-pw-capture", nullptr);
+	if (this->loop == nullptr) {
+		qCCritical(logCapture) << "Failed to create pipewire capture thread.";
+		return;
+	}
+
+	this->context = pw_context_new(pw_thread_loop_get_loop(this->loop), nullptr, 0);
+	if (this->context == nullptr) {
+		qCCritical(logCapture) << "Failed to create pipewire capture context.";
+		return;
+	}
+
+	if (pw_thread_loop_start(this->loop) != 0) {
+		qCCritical(logCapture) << "Failed to start pipewire capture thread.";
+		return;
+	}
+
+	this->lock();
+	this->core = pw_context_connect(this->context, nullptr, 0);
+	this->unlock();
+
+	if (this->core == nullptr) {
+		qCCritical(logCapture) << "Failed to connect pipewire capture context. Errno:" << errno;
+	}
+}
+
+PwCaptureLoop::~PwCaptureLoop() {
+	if (this->loop == nullptr) return;
+
+	pw_thread_loop_stop(this->loop);
+
+	if (this->context != nullptr) {
+		if (this->core != nullptr) pw_core_disconnect(this->core);
+		pw_context_destroy(this->context);
+	}
+
+	pw_thread_loop_destroy(this->loop);
+}
+
+bool PwCaptureLoop::isValid() const { return this->core != nullptr; }
+
+void PwCaptureLoop::lock() { pw_thread_loop_lock(this->loop); }
+void PwCaptureLoop::unlock() { pw_thread_loop_unlock(this->loop); }
+
+PwCaptureLoop* PwCaptureLoop::instance() {
+	static PwCaptureLoop* instance = nullptr; // NOLINT
+
+	if (instance == nullptr) {
+		instance = new PwCaptureLoop();
+	}
+
+	return instance;
+}
+
+PwAudioCapture::~PwAudioCapture() { this->stop(); }
+
+const pw_stream_events PwAudioCapture::EVENTS = {
+    .version = PW_VERSION_STREAM_EVENTS,
+    .param_changed = &PwAudioCapture::onParamChanged,
+    .process = &PwAudioCapture::onProcess,
+};
+
+bool PwAudioCapture::start(const QString& name, quint64 targetSerial, bool captureSink) {
+	this->stop();
+
+	auto* loop = PwCaptureLoop::instance();
+	if (!loop->isValid()) return false;
+
+	auto nameUtf8 = name.toUtf8();
+	auto target = QByteArray::number(targetSerial);
+
+	// clang-format off
+	auto* props = pw_properties_new(
+	    PW_KEY_MEDIA_TYPE, "Audio",
+	    PW_KEY_MEDIA_CATEGORY, "Monitor",
+	    PW_KEY_TARGET_OBJECT, target.constData(),
+	    // capturing the default node instead of a missing target would report the wrong audio
+	    "node.dont-fallback", "true",
+	    // don't keep the target from suspending
+	    PW_KEY_NODE_PASSIVE, "true",
+	    PW_KEY_NODE_DONT_RECONNECT, "true",
+	    PW_KEY_STREAM_DONT_REMIX, "true",
+	    nullptr
+	);
+	// clang-format on
+
+	if (captureSink) pw_properties_set(props, PW_KEY_STREAM_CAPTURE_SINK, "true");
+
+	auto buffer = std::array<quint8, 1024>();
+	auto builder = SPA_POD_BUILDER_INIT(buffer.data(), buffer.size());
+
+	auto info = spa_audio_info_raw();
+	info.format = SPA_AUDIO_FORMAT_F32;
+	const auto* format = spa_format_audio_raw_build(&builder, SPA_PARAM_EnumFormat, &info);
+
+	loop->lock();
+
+	this->channels = 0;
+	this->rate = 0;
+	this->stream = pw_stream_new(loop->core, nameUtf8.constData(), props);
+
+	if (this->stream == nullptr) {
+		loop->unlock();
+		qCWarning(logCapture) << "Failed to create capture stream for node" << targetSerial;
+		return false;
+	}
+
+	pw_stream_add_listener(this->stream, &this->listener.hook, &PwAudioCapture::EVENTS, this);
+
+	auto flags = static_cast<pw_stream_flags>(
+	    PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS | PW_STREAM_FLAG_DONT_RECONNECT
+	);
+
+	auto result = pw_stream_connect(this->stream, PW_DIRECTION_INPUT, PW_ID_ANY, flags, &format, 1);
+
+	loop->unlock();
+
+	if (result < 0) {
+		qCWarning(logCapture) << "Failed to connect capture stream for node" << targetSerial
+		                      << "- error" << result;
+		this->stop();
+		return false;
+	}
+
+	qCDebug(logCapture) << "Started capture stream for node" << targetSerial;
+	return true;
+}
+
+void PwAudioCapture::stop() {
+	if (this->stream == nullptr) return;
+
+	auto* loop = PwCaptureLoop::instance();
+	loop->lock();
+	this->listener.remove();
+	pw_stream_destroy(this->stream);
+	this->stream = nullptr;
+	loop->unlock();
+}
+
+bool PwAudioCapture::isRunning() const { return this->stream != nullptr; }
+
+void PwAudioCapture::onParamChanged(void* data, quint32 id, const spa_pod* param) {
+	auto* self = static_cast<PwAudioCapture*>(data);
+	if (param == nullptr || id != SPA_PARAM_Format) return;
+
+	auto info = spa_audio_info_raw();
+	if (spa_format_audio_raw_parse(param, &info) < 0) {
+		qCWarning(logCapture) << "Failed to parse negotiated capture format.";
+		return;
+	}
+
+	qCDebug(logCapture) << "Negotiated capture format with" << info.channels << "channels at"
+	                    << info.rate << "Hz";
+
+	self->channels = info.channels;
+	self->rate = info.rate;
+	self->onFormat(info.channels, info.rate);
+}
+
+void PwAudioCapture::onProcess(void* data) {
+	auto* self = static_cast<PwAudioCapture*>(data);
+
+	auto* buffer = pw_stream_dequeue_buffer(self->stream);
+	if (buffer == nullptr) return;
+
+	auto& spaData = buffer->buffer->datas[0]; // NOLINT
+
+	if (spaData.data != nullptr && spaData.chunk != nullptr && self->channels != 0) {
+		auto offset = std::min(spaData.chunk->offset, spaData.maxsize);
+		auto size = std::min(spaData.chunk->size, spaData.maxsize - offset);
+		auto frames = static_cast<quint32>(size / (sizeof(float) * self->channels));
+
+		const auto* samples = reinterpret_cast<const float*>( // NOLINT
+		    static_cast<const quint8*>(spaData.data) + offset // NOLINT
+		);
+
+		if (frames != 0) self->onSamples(samples, frames);
+	}
+
+	pw_stream_queue_buffer(self->stream, buffer);
+}
+
+PwNodeCaptureConsumer::PwNodeCaptureConsumer(QObject* parent): QObject(parent) {
+	QObject::connect(&this->timer, &QTimer::timeout, this, &PwNodeCaptureConsumer::onTimeout);
+}
+
+PwNodeIface* PwNodeCaptureConsumer::node() const { return this->mNode; }
+
+void PwNodeCaptureConsumer::setNode(PwNodeIface* node) {
+	if (node == this->mNode) return;
+
+	if (this->mNode != nullptr) {
+		QObject::disconnect(this->mNode, nullptr, this, nullptr);
+	}
+
+	if (node != nullptr) {
+		QObject::connect(node, &QObject::destroyed, this, &PwNodeCaptureConsumer::onNodeDestroyed);
+	}
+
+	this->mNode = node;
+	this->updateCapture();
+	emit this->nodeChanged();
+}
+
+void PwNodeCaptureConsumer::onNodeDestroyed() {
+	this->mNode = nullptr;
+	this->updateCapture();
+	emit this->nodeChanged();
+}
+
+bool PwNodeCaptureConsumer::enabled() const { return this->mEnabled; }
+
+void PwNodeCaptureConsumer::setEnabled(bool enabled) {
+	if (enabled == this->mEnabled) return;
+	this->mEnabled = enabled;
+	this->updateCapture();
+	emit this->enabledChanged();
+}
+
+qint32 PwNodeCaptureConsumer::updateInterval() const { return this->mUpdateInterval; }
+
+void PwNodeCaptureConsumer::setUpdateInterval(qint32 updateInterval) {
+	updateInterval = std::max(updateInterval, 1);
+	if (updateInterval == this->mUpdateInterval) return;
+
+	this->mUpdateInterval = updateInterval;
+	this->onUpdateIntervalChanged();
+	if (this->timer.isActive()) this->timer.start(updateInterval);
+	emit this->updateIntervalChanged();
+}
+
+void PwNodeCaptureConsumer::updateCapture() {
+	auto& capture = this->audioCapture();
+	capture.stop();
+	this->timer.stop();
+	this->staleMsecs = 0;
+	this->clearResults();
+
+	if (!this->mEnabled || this->mNode == nullptr) return;
+
+	auto started = capture.start(
+	    this->streamName(),
+	    this->mNode->node()->serial,
+	    this->mNode->isSink() && !this->mNode->isStream()
+	);
+
+	if (started) this->timer.start(this->mUpdateInterval);
+}
+
+void PwNodeCaptureConsumer::onTimeout() {
+	if (this->publishResults()) {
+		this->staleMsecs = 0;
+		return;
+	}
+
+	this->staleMsecs += this->mUpdateInterval;
+	if (this->staleMsecs >= STALE_RESULT_MSECS) this->clearResults();
+}
+
+} // namespace qs::service::pipewire
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <pipewire/context.h>
+#include <pipewire/core.h>
+#include <pipewire/stream.h>
+#include <pipewire/thread-loop.h>
+#include <qloggingcategory.h>
+#include <qobject.h>
+#include <qqmlintegration.h>
+#include <qstring.h>
+#include <qtclasshelpermacros.h>
+#include <qtimer.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+#include <spa/pod/pod.h>
+
+#include "core.hpp"
+
+namespace qs::service::pipewire {
+
+class PwNodeIface;
+
+Q_DECLARE_LOGGING_CATEGORY(logCapture);
+
+// Pipewire connection running on its own thread, used for streams that process
+// audio data and must not be delayed by (or delay) the GUI thread.
+class PwCaptureLoop {
+public:
+	~PwCaptureLoop();
+	Q_DISABLE_COPY_MOVE(PwCaptureLoop);
+
+	[[nodiscard]] bool isValid() const;
+
+	void lock();
+	void unlock();
+
+	pw_thread_loop* loop = nullptr;
+	pw_context* context = nullptr;
+	pw_core* core = nullptr;
+
+	static PwCaptureLoop* instance();
+
+private:
+	explicit PwCaptureLoop();
+};
+
+// Float32 capture stream targeting a single node by its object.serial.
+//
+// All virtual callbacks run on the capture thread. Subclasses must call stop()
+// in their destructor so no callbacks run during destruction.
+class PwAudioCapture {
+public:
+	PwAudioCapture() = default;
+	virtual ~PwAudioCapture();
+	Q_DISABLE_COPY_MOVE(PwAudioCapture);
+
+	// If captureSink is true the monitor ports of a sink will be captured instead of its input.
+	bool start(const QString& name, quint64 targetSerial, bool captureSink);
+	void stop();
+
+	[[nodiscard]] bool isRunning() const;
+
+protected:
+	virtual void onFormat(quint32 /*channels*/, quint32 /*rate*/) {}
+	// samples are interleaved and contain frames * channels entries.
+	virtual void onSamples(const float* samples, quint32 frames) = 0;
+
+	// only valid on the capture thread
+	quint32 channels = 0;
+	quint32 rate = 0;
+
+private:
+	static const pw_stream_events EVENTS;
+	static void onParamChanged(void* data, quint32 id, const spa_pod* param);
+	static void onProcess(void* data);
+
+	pw_stream* stream = nullptr;
+	SpaHook listener;
+};
+
+///! Base class of types that capture audio from a pipewire node.
+/// See @@PwNodeLevelMonitor and @@PwSpectrumAnalyzer.
+///
+/// Audio is captured on a dedicated thread, and results are published once per
+/// @@updateInterval. Sinks are captured through their monitor ports.
+///
+/// > [!INFO] Capturing audio has a small but constant cost. Disable capture using
+/// > @@enabled when its results are not visible.
+class PwNodeCaptureConsumer: public QObject {
+	Q_OBJECT;
+	// clang-format off
+	/// The node to capture audio from.
+	Q_PROPERTY(PwNodeIface* node READ node WRITE setNode NOTIFY nodeChanged);
+	/// If audio should be captured. Defaults to true.
+	Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged);
+	/// How often results are updated, in milliseconds. Defaults to 16, roughly once per frame.
+	///
+	/// Each update reports the audio captured over the preceding interval.
+	Q_PROPERTY(qint32 updateInterval READ updateInterval WRITE setUpdateInterval NOTIFY updateIntervalChanged);
+	// clang-format on
+	QML_ELEMENT;
+	QML_UNCREATABLE("base class");
+
+public:
+	explicit PwNodeCaptureConsumer(QObject* parent = nullptr);
+
+	[[nodiscard]] PwNodeIface* node() const;
+	void setNode(PwNodeIface* node);
+
+	[[nodiscard]] bool enabled() const;
+	void setEnabled(bool enabled);
+
+	[[nodiscard]] qint32 updateInterval() const;
+	void setUpdateInterval(qint32 updateInterval);
+
+signals:
+	void nodeChanged();
+	void enabledChanged();
+	void updateIntervalChanged();
+
+protected:
+	[[nodiscard]] virtual PwAudioCapture& audioCapture() = 0;
+	[[nodiscard]] virtual QString streamName() const = 0;
+
+	// Publishes the newest results of the capture. Returns false if nothing was captured
+	// since the last call.
+	virtual bool publishResults() = 0;
+	// Clears published results when capture stops or no audio has been captured for a while.
+	virtual void clearResults() = 0;
+	virtual void onUpdateIntervalChanged() {}
+
+private slots:
+	void onNodeDestroyed();
+	void onTimeout();
+
+private:
+	void updateCapture();
+
+	PwNodeIface* mNode = nullptr;
+	bool mEnabled = true;
+	qint32 mUpdateInterval = 16;
+	qint32 staleMsecs = 0;
+	QTimer timer;
+};
+
+} // namespace qs::service::pipewire
@@ -1,56 +1,70 @@
 #include "core.hpp"
 #include <cerrno>
+#include <functional>
+#include <utility>
+#include <vector>
 
 #include <pipewire/context.h>
 #include <pipewire/core.h>
 #include <pipewire/loop.h>
 #include <pipewire/pipewire.h>
+#include <pipewire/thread-loop.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
+#include <qmutex.h>
 #include <qobject.h>
-#include <qsocketnotifier.h>
+#include <qtypes.h>
 #include <spa/utils/defs.h>
+#include <spa/utils/dict.h>
 #include <spa/utils/hook.h>
 
 namespace qs::service::pipewire {
 
 Q_LOGGING_CATEGORY(logLoop, "quickshell.service.pipewire.loop", QtWarningMsg);
 
-PwCore::PwCore(QObject* parent): QObject(parent), notifier(QSocketNotifier::Read) {
+PwCore::PwCore(QObject* parent, bool connect): QObject(parent) {
+	if (!connect) return;
+
 	qCInfo(logLoop) << "Creating pipewire event loop.";
 	pw_init(nullptr, nullptr);
 
-	this->loop = pw_loop_new(nullptr);
-	if (this->loop == nullptr) {
+	this->threadLoop = pw_thread_loop_new("qs-pipewire", nullptr);
+	if (this->threadLoop == nullptr) {
 		qCCritical(logLoop) << "Failed to create pipewire event loop.";
 		return;
 	}
 
+	this->loop = pw_thread_loop_get_loop(this->threadLoop);
+
 	this->context = pw_context_new(this->loop, nullptr, 0);
 	if (this->context == nullptr) {
 		qCCritical(logLoop) << "Failed to create pipewire context.";
 		return;
 	}
 
+	qCInfo(logLoop) << "Starting pipewire event loop thread.";
+	if (pw_thread_loop_start(this->threadLoop) != 0) {
+		qCCritical(logLoop) << "Failed to start pipewire event loop thread.";
+		return;
+	}
+
 	qCInfo(logLoop) << "Connecting to pipewire server.";
+	this->lock();
 	this->core = pw_context_connect(this->context, nullptr, 0);
+	this->unlock();
+
 	if (this->core == nullptr) {
 		qCCritical(logLoop) << "Failed to connect pipewire context. Errno:" << errno;
 		return;
 	}
-
-	qCInfo(logLoop) << "Linking pipewire event loop.";
-	// Tie the pw event loop into qt.
-	auto fd = pw_loop_get_fd(this->loop);
-	this->notifier.setSocket(fd);
-	QObject::connect(&this->notifier, &QSocketNotifier::activated, this, &PwCore::poll);
-	this->notifier.setEnabled(true);
 }
 
 PwCore::~PwCore() {
 	qCInfo(logLoop) << "Destroying PwCore.";
 
-	if (this->loop != nullptr) {
+	if (this->threadLoop != nullptr) {
+		pw_thread_loop_stop(this->threadLoop);
+
 		if (this->context != nullptr) {
 			if (this->core != nullptr) {
 				pw_core_disconnect(this->core);
@@ -59,7 +73,7 @@ PwCore::~PwCore() {
 			pw_context_destroy(this->context);
 		}
 
-		pw_loop_destroy(this->loop);
+		pw_thread_loop_destroy(this->threadLoop);
 	}
 }
 
@@ -68,11 +82,58 @@ bool PwCore::isValid() const {
 	return this->core != nullptr;
 }
 
-void PwCore::poll() const {
-	qCDebug(logLoop) << "Pipewire event loop received new events, iterating.";
-	// Spin pw event loop.
-	pw_loop_iterate(this->loop, 0);
-	qCDebug(logLoop) << "Done iterating pipewire event loop.";
+void PwCore::lock() {
+	if (this->threadLoop != nullptr) pw_thread_loop_lock(this->threadLoop);
+}
+
+void PwCore::unlock() {
+	if (this->threadLoop != nullptr) pw_thread_loop_unlock(this->threadLoop);
+}
+
+quint64 PwCore::eventKey(quint32 object, EventKind kind, quint32 sub) {
+	return (static_cast<quint64>(object) << 32) | (static_cast<quint64>(kind) << 24)
+	     | (sub & 0xffffff);
+}
+
+void PwCore::post(quint64 key, std::function<void()> callback) {
+	auto locker = QMutexLocker(&this->eventMutex);
+
+	if (key != 0) {
+		auto existing = this->pendingKeys.find(key);
+
+		if (existing != this->pendingKeys.end()) {
+			// Drop the old event instead of replacing it in place, as it may be ordered
+			// before a removal that the new event must come after.
+			this->pendingEvents[*existing].callback = nullptr;
+			*existing = this->pendingEvents.size();
+		} else {
+			this->pendingKeys.insert(key, this->pendingEvents.size());
+		}
+	}
+
+	this->pendingEvents.push_back({.key = key, .callback = std::move(callback)});
+
+	if (!this->dispatchQueued) {
+		this->dispatchQueued = true;
+		QMetaObject::invokeMethod(this, &PwCore::dispatch, Qt::QueuedConnection);
+	}
+}
+
+void PwCore::dispatch() {
+	auto events = QVector<PendingEvent>();
+
+	{
+		auto locker = QMutexLocker(&this->eventMutex);
+		events.swap(this->pendingEvents);
+		this->pendingKeys.clear();
+		this->dispatchQueued = false;
+	}
+
+	qCDebug(logLoop) << "Dispatching" << events.size() << "pipewire events.";
+
+	for (auto& event: events) {
+		if (event.callback) event.callback();
+	}
 }
 
 SpaHook::SpaHook() { // NOLINT
@@ -80,8 +141,48 @@ SpaHook::SpaHook() { // NOLINT
 }
 
 void SpaHook::remove() {
+	// never added to a listener list
+	if (this->hook.link.next == nullptr) return;
+
 	spa_hook_remove(&this->hook);
 	spa_zero(this->hook);
 }
 
+PwDictCopy::PwDictCopy(const spa_dict* dict) {
+	if (dict == nullptr) return;
+
+	auto offsets = std::vector<std::pair<qsizetype, qsizetype>>();
+	offsets.reserve(dict->n_items);
+
+	const spa_dict_item* item = nullptr;
+	spa_dict_for_each(item, dict) {
+		auto keyOffset = this->strings.size();
+		this->strings.append(item->key).append('\0');
+
+		auto valueOffset = qsizetype(-1);
+		if (item->value != nullptr) {
+			valueOffset = this->strings.size();
+			this->strings.append(item->value).append('\0');
+		}
+
+		offsets.emplace_back(keyOffset, valueOffset);
+	}
+
+	// pointers are taken after all appends so reallocation can't invalidate them
+	const auto* base = this->strings.constData();
+	this->items.reserve(offsets.size());
+
+	for (auto [keyOffset, valueOffset]: offsets) {
+		this->items.push_back({
+		    .key = base + keyOffset,                                  // NOLINT
+		    .value = valueOffset == -1 ? nullptr : base + valueOffset, // NOLINT
+		});
+	}
+
+	this->mDict.items = this->items.data();
+	this->mDict.n_items = static_cast<quint32>(this->items.size());
+}
+
+const spa_dict* PwDictCopy::dict() const { return &this->mDict; }
+
 } // namespace qs::service::pipewire
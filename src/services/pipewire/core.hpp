@@ -1,38 +1,80 @@
 #pragma once
 
+#include <functional>
+#include <vector>
+
 #include <pipewire/context.h>
 #include <pipewire/core.h>
 #include <pipewire/loop.h>
 #include <pipewire/proxy.h>
+#include <pipewire/thread-loop.h>
+#include <qbytearray.h>
+#include <qcontainerfwd.h>
+#include <qhash.h>
 #include <qloggingcategory.h>
+#include <qmutex.h>
 #include <qobject.h>
-#include <qsocketnotifier.h>
 #include <qtclasshelpermacros.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
+#include <spa/utils/dict.h>
 #include <spa/utils/hook.h>
 
 namespace qs::service::pipewire {
 
+// Pipewire connection running on its own thread.
+//
+// All pipewire callbacks run on the pipewire thread, and must hand their results to the
+// GUI thread using post(). Any pipewire call made from the GUI thread must hold the loop lock.
 class PwCore: public QObject {
 	Q_OBJECT;
 
 public:
-	explicit PwCore(QObject* parent = nullptr);
+	// If connect is false no pipewire loop is created and only post() is usable,
+	// which allows recorded events to be replayed without a pipewire server.
+	explicit PwCore(QObject* parent = nullptr, bool connect = true);
 	~PwCore() override;
 	Q_DISABLE_COPY_MOVE(PwCore);
 
+	enum EventKind : quint8 {
+		NodeInfoEvent = 1,
+		NodeParamEvent,
+		LinkInfoEvent,
+	};
+
 	[[nodiscard]] bool isValid() const;
 
+	// Locks the pipewire thread. Recursive.
+	void lock();
+	void unlock();
+
+	// Queues callback to run on the GUI thread. All queued callbacks are run together in
+	// the next event loop iteration, in the order they were posted.
+	//
+	// If key is nonzero and a callback with the same key is still pending, the pending
+	// callback is dropped. Only use keys for updates that carry the object's full state.
+	void post(quint64 key, std::function<void()> callback);
+
+	static quint64 eventKey(quint32 object, EventKind kind, quint32 sub = 0);
+
+	pw_thread_loop* threadLoop = nullptr;
 	pw_loop* loop = nullptr;
 	pw_context* context = nullptr;
 	pw_core* core = nullptr;
 
 private slots:
-	void poll() const;
+	void dispatch();
 
 private:
-	QSocketNotifier notifier;
+	struct PendingEvent {
+		quint64 key = 0;
+		std::function<void()> callback;
+	};
+
+	QMutex eventMutex;
+	QVector<PendingEvent> pendingEvents;
+	QHash<quint64, qsizetype> pendingKeys;
+	bool dispatchQueued = false;
 };
 
 template <typename T>
@@ -40,6 +82,7 @@ class PwObject {
 public:
 	explicit PwObject(T* object = nullptr): object(object) {}
 	~PwObject() {
+		if (this->object == nullptr) return;
 		pw_proxy_destroy(reinterpret_cast<pw_proxy*>(this->object)); // NOLINT
 	}
 
@@ -56,4 +99,20 @@ public:
 	spa_hook hook;
 };
 
+// Owned copy of a spa_dict, used to pass props received on the pipewire thread
+// to the GUI thread.
+class PwDictCopy {
+public:
+	explicit PwDictCopy(const spa_dict* dict);
+	~PwDictCopy() = default;
+	Q_DISABLE_COPY_MOVE(PwDictCopy);
+
+	[[nodiscard]] const spa_dict* dict() const;
+
+private:
+	QByteArray strings;
+	std::vector<spa_dict_item> items;
+	spa_dict mDict {};
+};
+
 } // namespace qs::service::pipewire
@@ -0,0 +1,150 @@
+#include "levels.hpp"
+#include <algorithm>
+#include <cmath>
+
+#include <qcontainerfwd.h>
+#include <qobject.h>
+#include <qstring.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+#include <spa/param/audio/raw.h>
+
+#include "capture.hpp"
+
+namespace qs::service::pipewire {
+
+namespace {
+
+// Updates running peak and sum of squares for each channel of an interleaved buffer.
+// Channels are processed one at a time with local accumulators and no branches in
+// the inner loop, which lets the compiler vectorize the common mono and stereo cases.
+void accumulateLevels(
+    const float* samples,
+    quint32 frames,
+    quint32 stride,
+    quint32 channels,
+    float* peaks,
+    float* squares
+) {
+	// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+	for (quint32 channel = 0; channel != channels; channel++) {
+		const auto* channelSamples = samples + channel;
+		auto peak = peaks[channel];
+		auto square = squares[channel];
+
+		for (quint32 frame = 0; frame != frames; frame++) {
+			auto sample = channelSamples[static_cast<qsizetype>(frame) * stride];
+			auto magnitude = std::fabs(sample);
+			peak = magnitude > peak ? magnitude : peak;
+			square += sample * sample;
+		}
+
+		peaks[channel] = peak;
+		squares[channel] = square;
+	}
+	// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+} // namespace
+
+PwLevelCapture::~PwLevelCapture() { this->stop(); }
+
+void PwLevelCapture::setWindow(qint32 msecs) {
+	this->windowMsecs.store(std::max(msecs, 1), std::memory_order_relaxed);
+}
+
+void PwLevelCapture::onFormat(quint32 /*channels*/, quint32 /*rate*/) { this->resetWindow(); }
+
+void PwLevelCapture::resetWindow() {
+	auto msecs = static_cast<quint64>(this->windowMsecs.load(std::memory_order_relaxed));
+	this->windowFrames = std::max(static_cast<quint32>(this->rate * msecs / 1000), 1u);
+
+	this->accumulatedFrames = 0;
+	this->peaks.fill(0);
+	this->squares.fill(0);
+}
+
+void PwLevelCapture::onSamples(const float* samples, quint32 frames) {
+	auto channels = std::min(this->channels, static_cast<quint32>(SPA_AUDIO_MAX_CHANNELS));
+
+	while (frames != 0) {
+		auto count = std::min(frames, this->windowFrames - this->accumulatedFrames);
+
+		accumulateLevels(
+		    samples,
+		    count,
+		    this->channels,
+		    channels,
+		    this->peaks.data(),
+		    this->squares.data()
+		);
+
+		samples += static_cast<qsizetype>(count) * this->channels; // NOLINT
+		frames -= count;
+		this->accumulatedFrames += count;
+
+		if (this->accumulatedFrames >= this->windowFrames) this->publish();
+	}
+}
+
+void PwLevelCapture::publish() {
+	auto channels = std::min(this->channels, static_cast<quint32>(SPA_AUDIO_MAX_CHANNELS));
+	auto& frame = this->levels.writeBuffer();
+
+	frame.channels = channels;
+	for (quint32 i = 0; i != channels; i++) {
+		frame.peaks[i] = this->peaks[i];
+		frame.rms[i] = std::sqrt(this->squares[i] / static_cast<float>(this->accumulatedFrames));
+	}
+
+	this->levels.publish();
+
+	// pick up window changes at the start of the next window
+	this->resetWindow();
+}
+
+PwNodeLevelMonitor::PwNodeLevelMonitor(QObject* parent): PwNodeCaptureConsumer(parent) {
+	this->capture.setWindow(this->updateInterval());
+}
+
+QVector<float> PwNodeLevelMonitor::channelPeaks() const { return this->mChannelPeaks; }
+QVector<float> PwNodeLevelMonitor::channelRms() const { return this->mChannelRms; }
+float PwNodeLevelMonitor::peak() const { return this->mPeak; }
+float PwNodeLevelMonitor::rms() const { return this->mRms; }
+
+PwAudioCapture& PwNodeLevelMonitor::audioCapture() { return this->capture; }
+QString PwNodeLevelMonitor::streamName() const { return "quickshell-level-monitor"; }
+
+void PwNodeLevelMonitor::onUpdateIntervalChanged() {
+	this->capture.setWindow(this->updateInterval());
+}
+
+bool PwNodeLevelMonitor::publishResults() {
+	if (!this->capture.levels.update()) return false;
+
+	const auto& frame = this->capture.levels.readBuffer();
+
+	auto peaks = QVector<float>(frame.peaks.begin(), frame.peaks.begin() + frame.channels);
+	auto rms = QVector<float>(frame.rms.begin(), frame.rms.begin() + frame.channels);
+
+	if (peaks == this->mChannelPeaks && rms == this->mChannelRms) return true;
+
+	this->mChannelPeaks = peaks;
+	this->mChannelRms = rms;
+	this->mPeak = peaks.isEmpty() ? 0 : *std::ranges::max_element(peaks);
+	this->mRms = rms.isEmpty() ? 0 : *std::ranges::max_element(rms);
+	emit this->levelsChanged();
+	return true;
+}
+
+void PwNodeLevelMonitor::clearResults() {
+	if (this->mChannelPeaks.isEmpty() && this->mChannelRms.isEmpty()) return;
+
+	this->mChannelPeaks.clear();
+	this->mChannelRms.clear();
+	this->mPeak = 0;
+	this->mRms = 0;
+	emit this->levelsChanged();
+}
+
+} // namespace qs::service::pipewire
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <qcontainerfwd.h>
+#include <qobject.h>
+#include <qqmlintegration.h>
+#include <qstring.h>
+#include <qtclasshelpermacros.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+#include <spa/param/audio/raw.h>
+
+#include "../../core/triplebuffer.hpp"
+#include "capture.hpp"
+
+namespace qs::service::pipewire {
+
+struct PwLevelFrame {
+	quint32 channels = 0;
+	std::array<float, SPA_AUDIO_MAX_CHANNELS> peaks {};
+	std::array<float, SPA_AUDIO_MAX_CHANNELS> rms {};
+};
+
+class PwLevelCapture: public PwAudioCapture {
+public:
+	PwLevelCapture() = default;
+	~PwLevelCapture() override;
+	Q_DISABLE_COPY_MOVE(PwLevelCapture);
+
+	void setWindow(qint32 msecs);
+
+	TripleBuffer<PwLevelFrame> levels;
+
+protected:
+	void onFormat(quint32 channels, quint32 rate) override;
+	void onSamples(const float* samples, quint32 frames) override;
+
+private:
+	void publish();
+	void resetWindow();
+
+	std::atomic<qint32> windowMsecs = 16;
+	quint32 windowFrames = 0;
+	quint32 accumulatedFrames = 0;
+	std::array<float, SPA_AUDIO_MAX_CHANNELS> peaks {};
+	std::array<float, SPA_AUDIO_MAX_CHANNELS> squares {};
+};
+
+///! Live audio levels of a pipewire node.
+/// Measures the peak and RMS levels of the audio passing through a node.
+///
+/// Levels are linear amplitudes, where `1.0` is full scale. See @@PwNodeCaptureConsumer
+/// for the properties controlling capture.
+///
+/// #### Example
+/// ```qml
+/// PwNodeLevelMonitor {
+///   id: monitor
+///   node: Pipewire.defaultAudioSink
+/// }
+///
+/// Rectangle {
+///   height: 10
+///   width: 200 * monitor.peak
+/// }
+/// ```
+class PwNodeLevelMonitor: public PwNodeCaptureConsumer {
+	Q_OBJECT;
+	/// The peak level of each channel of the node.
+	Q_PROPERTY(QVector<float> channelPeaks READ channelPeaks NOTIFY levelsChanged);
+	/// The RMS level of each channel of the node.
+	Q_PROPERTY(QVector<float> channelRms READ channelRms NOTIFY levelsChanged);
+	/// The highest peak level of all channels.
+	Q_PROPERTY(float peak READ peak NOTIFY levelsChanged);
+	/// The highest RMS level of all channels.
+	Q_PROPERTY(float rms READ rms NOTIFY levelsChanged);
+	QML_ELEMENT;
+
+public:
+	explicit PwNodeLevelMonitor(QObject* parent = nullptr);
+
+	[[nodiscard]] QVector<float> channelPeaks() const;
+	[[nodiscard]] QVector<float> channelRms() const;
+	[[nodiscard]] float peak() const;
+	[[nodiscard]] float rms() const;
+
+signals:
+	void levelsChanged();
+
+protected:
+	[[nodiscard]] PwAudioCapture& audioCapture() override;
+	[[nodiscard]] QString streamName() const override;
+	bool publishResults() override;
+	void clearResults() override;
+	void onUpdateIntervalChanged() override;
+
+private:
+	QVector<float> mChannelPeaks;
+	QVector<float> mChannelRms;
+	float mPeak = 0;
+	float mRms = 0;
+	PwLevelCapture capture;
+};
+
+} // namespace qs::service::pipewire
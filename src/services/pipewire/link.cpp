@@ -10,6 +10,7 @@
 #include <qtypes.h>
 #include <spa/utils/dict.h>
 
+#include "core.hpp"
 #include "registry.hpp"
 
 namespace qs::service::pipewire {
@@ -24,10 +25,9 @@ void PwLink::bindHooks() {
 	pw_link_add_listener(this->proxy(), &this->listener.hook, &PwLink::EVENTS, this);
 }
 
-void PwLink::unbindHooks() {
-	this->listener.remove();
-	this->setState(PW_LINK_STATE_UNLINKED);
-}
+void PwLink::unbindHooks() { this->listener.remove(); }
+
+void PwLink::onUnbound() { this->setState(PW_LINK_STATE_UNLINKED); }
 
 void PwLink::initProps(const spa_dict* props) {
 	qCDebug(logLink) << "Parsing initial SPA props of link" << this;
@@ -61,13 +61,27 @@ const pw_link_events PwLink::EVENTS = {
 
 void PwLink::onInfo(void* data, const struct pw_link_info* info) {
 	auto* self = static_cast<PwLink*>(data);
-	qCDebug(logLink) << "Got link info update for" << self << "with mask" << info->change_mask;
-	self->setOutputNode(info->output_node_id);
-	self->setInputNode(info->input_node_id);
+	auto* registry = self->registry;
+	auto id = self->id;
 
-	if ((info->change_mask & PW_LINK_CHANGE_MASK_STATE) != 0) {
-		self->setState(info->state);
-	}
+	// info is cumulative, so a newer update fully replaces any pending one
+	auto outputNode = info->output_node_id;
+	auto inputNode = info->input_node_id;
+	auto state = info->state;
+
+	registry->core->post(PwCore::eventKey(id, PwCore::LinkInfoEvent), [=]() {
+		if (auto* link = registry->links.value(id)) link->updateInfo(outputNode, inputNode, state);
+	});
+}
+
+void PwLink::updateInfo(quint32 outputNode, quint32 inputNode, pw_link_state state) {
+	// may arrive after the link was unbound
+	if (!this->bound) return;
+
+	qCDebug(logLink) << "Got link info update for" << this;
+	this->setOutputNode(outputNode);
+	this->setInputNode(inputNode);
+	this->setState(state);
 }
 
 quint32 PwLink::outputNode() const { return this->mOutputNode; }
@@ -42,6 +42,7 @@ class PwLink: public PwBindable<pw_link, TYPE_INTERFACE_Link, PW_VERSION_LINK> {
 public:
 	void bindHooks() override;
 	void unbindHooks() override;
+	void onUnbound() override;
 	void initProps(const spa_dict* props) override;
 
 	[[nodiscard]] quint32 outputNode() const;
@@ -55,6 +56,8 @@ private:
 	static const pw_link_events EVENTS;
 	static void onInfo(void* data, const struct pw_link_info* info);
 
+	void updateInfo(quint32 outputNode, quint32 inputNode, pw_link_state state);
+
 	void setOutputNode(quint32 outputNode);
 	void setInputNode(quint32 inputNode);
 	void setState(pw_link_state state);
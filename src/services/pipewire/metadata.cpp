@@ -3,6 +3,7 @@
 #include <cstring>
 
 #include <pipewire/extensions/metadata.h>
+#include <qbytearray.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qobject.h>
@@ -10,6 +11,7 @@
 #include <qtypes.h>
 #include <spa/utils/json.h>
 
+#include "core.hpp"
 #include "registry.hpp"
 
 namespace qs::service::pipewire {
@@ -39,7 +41,25 @@ int PwMetadata::onProperty(
 	                 << "key:" << QString(key) << "type:" << QString(type)
 	                 << "value:" << QString(value);
 
-	emit self->registry->metadataUpdate(self, subject, key, type, value);
+	auto* registry = self->registry;
+	auto id = self->id;
+	auto keyStr = QByteArray(key);
+	auto typeStr = QByteArray(type);
+	auto valueStr = QByteArray(value);
+
+	// metadata updates are keyed by subject and key, and are rare enough not to coalesce
+	registry->core->post(0, [=]() {
+		auto* meta = registry->metadata.value(id);
+		if (meta == nullptr) return;
+
+		emit registry->metadataUpdate(
+		    meta,
+		    subject,
+		    keyStr.isNull() ? nullptr : keyStr.constData(),
+		    typeStr.isNull() ? nullptr : typeStr.constData(),
+		    valueStr.isNull() ? nullptr : valueStr.constData()
+		);
+	});
 
 	// ideally we'd dealloc metadata that wasn't picked up but there's no information
 	// available about if updates can come in later, so I assume they can.
@@ -1,17 +1,26 @@
 #include "node.hpp"
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <mutex>
+#include <utility>
 
 #include <pipewire/core.h>
+#include <pipewire/keys.h>
 #include <pipewire/node.h>
+#include <qbytearray.h>
 #include <qcontainerfwd.h>
+#include <qhash.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
+#include <qmutex.h>
 #include <qobject.h>
+#include <qtimer.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
+#include <qvariant.h>
 #include <spa/node/keys.h>
 #include <spa/param/param.h>
 #include <spa/param/props.h>
@@ -27,6 +36,28 @@ namespace qs::service::pipewire {
 
 Q_LOGGING_CATEGORY(logNode, "quickshell.service.pipewire.node", QtWarningMsg);
 
+namespace {
+
+// Minimum time between volume writes to the server, roughly one frame.
+constexpr qint32 VOLUME_WRITE_INTERVAL = 16;
+
+// Longest time to wait for the echo of a volume write before trusting the server's updates again.
+constexpr qint32 VOLUME_ECHO_TIMEOUT = 500;
+
+// Volumes go through a cube and cube root on the way to the server and back,
+// so echoes of written values may not be bit identical.
+bool volumesEqual(const QVector<float>& a, const QVector<float>& b) {
+	if (a.size() != b.size()) return false;
+
+	for (qsizetype i = 0; i != a.size(); i++) {
+		if (std::fabs(a[i] - b[i]) > 0.0001f) return false;
+	}
+
+	return true;
+}
+
+} // namespace
+
 QString PwAudioChannel::toString(Enum value) {
 	switch (value) {
 	case Unknown: return "Unknown";
@@ -78,14 +109,90 @@ QString PwAudioChannel::toString(Enum value) {
 	}
 }
 
+PwNodeProperties::PwNodeProperties(const spa_dict* dict) {
+	if (dict == nullptr) return;
+
+	this->entries.reserve(dict->n_items);
+
+	const spa_dict_item* item = nullptr;
+	spa_dict_for_each(item, dict) {
+		this->entries.push_back({
+		    .key = PwNodeProperties::internKey(item->key),
+		    .value = QByteArray(item->value),
+		});
+	}
+
+	std::ranges::sort(this->entries, [](const Entry& a, const Entry& b) { return a.key < b.key; });
+}
+
+QString PwNodeProperties::internKey(const char* key) {
+	// Node properties are parsed on the pipewire thread, but the lock keeps this safe to use
+	// from anywhere. The set of keys in use is small and never shrinks meaningfully.
+	static QMutex mutex;
+	static QHash<QByteArray, QString> keys; // NOLINT
+
+	auto lookup = QByteArray::fromRawData(key, static_cast<qsizetype>(strlen(key)));
+	auto locker = QMutexLocker(&mutex);
+
+	auto iter = keys.find(lookup);
+	if (iter == keys.end()) {
+		auto owned = QByteArray(lookup.constData(), lookup.size());
+		iter = keys.insert(owned, QString::fromUtf8(owned));
+	}
+
+	return *iter;
+}
+
+bool PwNodeProperties::isEmpty() const { return this->entries.isEmpty(); }
+
+const QVariantMap& PwNodeProperties::toVariantMap() const {
+	if (!this->variantMap) {
+		auto map = QVariantMap();
+
+		for (const auto& entry: this->entries) {
+			map.insert(entry.key, QString::fromUtf8(entry.value));
+		}
+
+		this->variantMap = std::move(map);
+	}
+
+	return *this->variantMap;
+}
+
+QVector<QString> PwNodeProperties::diff(const PwNodeProperties& other) const {
+	auto changed = QVector<QString>();
+
+	// both sides are sorted, so a single merge pass finds every difference
+	auto a = this->entries.begin();
+	auto b = other.entries.begin();
+
+	while (a != this->entries.end() || b != other.entries.end()) {
+		if (b == other.entries.end() || (a != this->entries.end() && a->key < b->key)) {
+			changed.push_back(a->key);
+			++a;
+		} else if (a == this->entries.end() || b->key < a->key) {
+			changed.push_back(b->key);
+			++b;
+		} else {
+			if (a->value != b->value) changed.push_back(a->key);
+			++a;
+			++b;
+		}
+	}
+
+	return changed;
+}
+
 void PwNode::bindHooks() {
 	pw_node_add_listener(this->proxy(), &this->listener.hook, &PwNode::EVENTS, this);
 }
 
-void PwNode::unbindHooks() {
-	this->listener.remove();
-	this->properties.clear();
-	emit this->propertiesChanged();
+void PwNode::unbindHooks() { this->listener.remove(); }
+
+void PwNode::onUnbound() {
+	auto changed = PwNodeProperties().diff(this->properties);
+	this->properties = PwNodeProperties();
+	if (!changed.isEmpty()) emit this->propertiesChanged(changed);
 
 	if (this->boundData != nullptr) {
 		this->boundData->onUnbind();
@@ -125,6 +232,10 @@ void PwNode::initProps(const spa_dict* props) {
 		this->nick = nodeNick;
 	}
 
+	if (const auto* serial = spa_dict_lookup(props, PW_KEY_OBJECT_SERIAL)) {
+		this->serial = QByteArray(serial).toULongLong();
+	}
+
 	if (this->type == PwNodeType::Audio) {
 		this->boundData = new PwNodeBoundAudio(this);
 	}
@@ -140,13 +251,19 @@ void PwNode::onInfo(void* data, const pw_node_info* info) {
 	auto* self = static_cast<PwNode*>(data);
 
 	if ((info->change_mask & PW_NODE_CHANGE_MASK_PROPS) != 0) {
-		auto properties = QMap<QString, QString>();
-
-		const spa_dict_item* item = nullptr;
-		spa_dict_for_each(item, info->props) { properties.insert(item->key, item->value); }
-
-		self->properties = properties;
-		emit self->propertiesChanged();
+		// Properties are parsed here to keep them off the GUI thread. Info always carries
+		// the full property set, so only the newest pending update has to be applied.
+		auto properties = PwNodeProperties(info->props);
+
+		auto* registry = self->registry;
+		auto id = self->id;
+
+		registry->core->post(
+		    PwCore::eventKey(id, PwCore::NodeInfoEvent),
+		    [registry, id, properties = std::move(properties)]() {
+			    if (auto* node = registry->nodes.value(id)) node->updateProperties(properties);
+		    }
+		);
 	}
 
 	if (self->boundData != nullptr) {
@@ -163,13 +280,66 @@ void PwNode::onParam(
     const spa_pod* param
 ) {
 	auto* self = static_cast<PwNode*>(data);
-	if (self->boundData != nullptr) {
-		self->boundData->onSpaParam(id, index, param);
-	}
+	if (self->boundData == nullptr || param == nullptr) return;
+
+	// the pod is only valid for the duration of the callback
+	auto paramCopy = QByteArray(reinterpret_cast<const char*>(param), SPA_POD_SIZE(param)); // NOLINT
+
+	auto* registry = self->registry;
+	auto nodeId = self->id;
+
+	// the first param of each id carries its full state and can be coalesced
+	auto key = index == 0 ? PwCore::eventKey(nodeId, PwCore::NodeParamEvent, id) : 0;
+
+	registry->core->post(key, [registry, nodeId, id, index, paramCopy = std::move(paramCopy)]() {
+		if (auto* node = registry->nodes.value(nodeId)) node->updateParam(id, index, paramCopy);
+	});
+}
+
+void PwNode::updateProperties(const PwNodeProperties& properties) {
+	// may arrive after the node was unbound
+	if (!this->bound) return;
+
+	auto changed = this->properties.diff(properties);
+	if (changed.isEmpty()) return;
+
+	qCDebug(logNode) << "Properties of" << this << "changed:" << changed;
+	this->properties = properties;
+	emit this->propertiesChanged(changed);
+}
+
+void PwNode::updateParam(quint32 id, quint32 index, const QByteArray& param) {
+	if (!this->bound || this->boundData == nullptr) return;
+
+	const auto* pod = reinterpret_cast<const spa_pod*>(param.constData()); // NOLINT
+	this->boundData->onSpaParam(id, index, pod);
+}
+
+PwNodeBoundAudio::PwNodeBoundAudio(PwNode* node): node(node) {
+	this->volumeWriteTimer.setSingleShot(true);
+	this->volumeWriteTimer.setInterval(VOLUME_WRITE_INTERVAL);
+
+	QObject::connect(
+	    &this->volumeWriteTimer,
+	    &QTimer::timeout,
+	    this,
+	    &PwNodeBoundAudio::onVolumeWriteTimeout
+	);
+
+	this->volumeEchoTimer.setSingleShot(true);
+	this->volumeEchoTimer.setInterval(VOLUME_ECHO_TIMEOUT);
+
+	QObject::connect(
+	    &this->volumeEchoTimer,
+	    &QTimer::timeout,
+	    this,
+	    &PwNodeBoundAudio::onVolumeEchoTimeout
+	);
 }
 
 void PwNodeBoundAudio::onInfo(const pw_node_info* info) {
-	if ((info->change_mask & PW_NODE_CHANGE_MASK_PARAMS) != 0) {
+	// already on the pipewire thread, so params can be requested without a GUI thread round trip
+	if ((info->change_mask & PW_NODE_CHANGE_MASK_PARAMS) != 0 && this->node->proxy() != nullptr) {
 		for (quint32 i = 0; i < info->n_params; i++) {
 			auto& param = info->params[i]; // NOLINT
 
@@ -217,6 +387,7 @@ void PwNodeBoundAudio::updateVolumeFromParam(const spa_pod* param) {
 	const auto* volumes = reinterpret_cast<const spa_pod_array*>(&volumesProp->value);   // NOLINT
 	const auto* channels = reinterpret_cast<const spa_pod_array*>(&channelsProp->value); // NOLINT
 
+	auto linearVolumesVec = QVector<float>();
 	auto volumesVec = QVector<float>();
 	auto channelsVec = QVector<PwAudioChannel::Enum>();
 
@@ -225,6 +396,7 @@ void PwNodeBoundAudio::updateVolumeFromParam(const spa_pod* param) {
 		// Cubing behavior found in MPD source, and appears to corrospond to everyone else's measurements correctly.
 		auto linear = *reinterpret_cast<float*>(iter); // NOLINT
 		auto visual = std::cbrt(linear);
+		linearVolumesVec.push_back(linear);
 		volumesVec.push_back(visual);
 	}
 
@@ -239,18 +411,40 @@ void PwNodeBoundAudio::updateVolumeFromParam(const spa_pod* param) {
 		return;
 	}
 
+	if (!this->writtenVolumes.isEmpty() && channelsVec == this->mChannels) {
+		if (volumesEqual(linearVolumesVec, this->writtenVolumes)) {
+			// echo of the last write, which the local volumes already reflect
+			qCDebug(logNode) << "Got echo of volume write to" << this->node;
+			this->volumeEchoTimer.stop();
+			this->writtenVolumes.clear();
+			this->heldVolumes.clear();
+		} else {
+			qCDebug(logNode) << "Holding volume update of" << this->node << "while writing volumes.";
+			this->heldVolumes = volumesVec;
+		}
+
+		return;
+	}
+
+	this->updateVolumes(channelsVec, volumesVec);
+}
+
+void PwNodeBoundAudio::updateVolumes(
+    const QVector<PwAudioChannel::Enum>& channels,
+    const QVector<float>& volumes
+) {
 	// It is important that the lengths of channels and volumes stay in sync whenever you read them.
 	auto channelsChanged = false;
 	auto volumesChanged = false;
 
-	if (this->mChannels != channelsVec) {
-		this->mChannels = channelsVec;
+	if (this->mChannels != channels) {
+		this->mChannels = channels;
 		channelsChanged = true;
 		qCDebug(logNode) << "Got updated channels of" << this->node << '-' << this->mChannels;
 	}
 
-	if (this->mVolumes != volumesVec) {
-		this->mVolumes = volumesVec;
+	if (!volumesEqual(this->mVolumes, volumes)) {
+		this->mVolumes = volumes;
 		volumesChanged = true;
 		qCDebug(logNode) << "Got updated volumes of" << this->node << '-' << this->mVolumes;
 	}
@@ -285,6 +479,12 @@ void PwNodeBoundAudio::updateMutedFromParam(const spa_pod* param) {
 }
 
 void PwNodeBoundAudio::onUnbind() {
+	this->volumeWriteTimer.stop();
+	this->volumeEchoTimer.stop();
+	this->volumeWritePending = false;
+	this->writtenVolumes.clear();
+	this->heldVolumes.clear();
+
 	this->mChannels.clear();
 	this->mVolumes.clear();
 	emit this->channelsChanged();
@@ -314,7 +514,12 @@ void PwNodeBoundAudio::setMuted(bool muted) {
 
 	qCDebug(logNode) << "Changed muted state of" << this->node << "to" << muted;
 	this->mMuted = muted;
-	pw_node_set_param(this->node->proxy(), SPA_PARAM_Props, 0, static_cast<spa_pod*>(pod));
+
+	{
+		auto guard = std::lock_guard(*this->node->core());
+		pw_node_set_param(this->node->proxy(), SPA_PARAM_Props, 0, static_cast<spa_pod*>(pod));
+	}
+
 	emit this->mutedChanged();
 }
 
@@ -360,11 +565,25 @@ void PwNodeBoundAudio::setVolumes(const QVector<float>& volumes) {
 		return;
 	}
 
+	qCDebug(logNode) << "Changed volumes of" << this->node << "to" << volumes;
+	this->mVolumes = volumes;
+
+	if (this->volumeWriteTimer.isActive()) {
+		// sent when the timer fires, along with any other changes made before then
+		this->volumeWritePending = true;
+	} else {
+		this->writeVolumes();
+	}
+
+	emit this->volumesChanged();
+}
+
+void PwNodeBoundAudio::writeVolumes() {
 	auto buffer = std::array<quint32, 1024>();
 	auto builder = SPA_POD_BUILDER_INIT(buffer.data(), buffer.size());
 
 	auto cubedVolumes = QVector<float>();
-	for (auto volume: volumes) {
+	for (auto volume: this->mVolumes) {
 		cubedVolumes.push_back(volume * volume * volume);
 	}
 
@@ -375,10 +594,44 @@ void PwNodeBoundAudio::setVolumes(const QVector<float>& volumes) {
 	);
 	// clang-format on
 
-	qCDebug(logNode) << "Changed volumes of" << this->node << "to" << volumes;
-	this->mVolumes = volumes;
-	pw_node_set_param(this->node->proxy(), SPA_PARAM_Props, 0, static_cast<spa_pod*>(pod));
-	emit this->volumesChanged();
+	qCDebug(logNode) << "Writing volumes of" << this->node << '-' << this->mVolumes;
+
+	{
+		auto guard = std::lock_guard(*this->node->core());
+		pw_node_set_param(this->node->proxy(), SPA_PARAM_Props, 0, static_cast<spa_pod*>(pod));
+	}
+
+	this->writtenVolumes = cubedVolumes;
+	this->volumeWriteTimer.start();
+	this->volumeEchoTimer.start();
+}
+
+void PwNodeBoundAudio::onVolumeWriteTimeout() {
+	if (this->node->proxy() == nullptr) return;
+
+	if (this->volumeWritePending) {
+		this->volumeWritePending = false;
+		this->writeVolumes();
+	}
+}
+
+void PwNodeBoundAudio::onVolumeEchoTimeout() {
+	// The echo of the last write never arrived, most likely because the server adjusted the
+	// written value. The last held update is the server's view, unless it is what was written.
+	auto written = QVector<float>();
+	for (auto volume: this->writtenVolumes) {
+		written.push_back(std::cbrt(volume));
+	}
+
+	auto volumes = this->heldVolumes;
+	this->writtenVolumes.clear();
+	this->heldVolumes.clear();
+
+	if (this->node->proxy() == nullptr || this->volumeWritePending) return;
+
+	if (!volumes.isEmpty() && !volumesEqual(volumes, written)) {
+		this->updateVolumes(this->mChannels, volumes);
+	}
 }
 
 } // namespace qs::service::pipewire
@@ -1,15 +1,19 @@
 #pragma once
 
+#include <optional>
+
 #include <pipewire/core.h>
 #include <pipewire/node.h>
 #include <pipewire/type.h>
+#include <qbytearray.h>
 #include <qcontainerfwd.h>
-#include <qmap.h>
 #include <qobject.h>
 #include <qqmlintegration.h>
 #include <qtclasshelpermacros.h>
+#include <qtimer.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
+#include <qvariant.h>
 #include <spa/param/audio/raw.h>
 #include <spa/pod/pod.h>
 
@@ -98,6 +102,7 @@ public:
 	virtual ~PwNodeBoundData() = default;
 	Q_DISABLE_COPY_MOVE(PwNodeBoundData);
 
+	// runs on the pipewire thread
 	virtual void onInfo(const pw_node_info* /*info*/) {}
 	virtual void onSpaParam(quint32 /*id*/, quint32 /*index*/, const spa_pod* /*param*/) {}
 	virtual void onUnbind() {}
@@ -109,7 +114,7 @@ class PwNodeBoundAudio
 	Q_OBJECT;
 
 public:
-	explicit PwNodeBoundAudio(PwNode* node): node(node) {}
+	explicit PwNodeBoundAudio(PwNode* node);
 
 	void onInfo(const pw_node_info* info) override;
 	void onSpaParam(quint32 id, quint32 index, const spa_pod* param) override;
@@ -131,14 +136,60 @@ signals:
 	void channelsChanged();
 	void mutedChanged();
 
+private slots:
+	void onVolumeWriteTimeout();
+	void onVolumeEchoTimeout();
+
 private:
 	void updateVolumeFromParam(const spa_pod* param);
 	void updateMutedFromParam(const spa_pod* param);
+	void updateVolumes(const QVector<PwAudioChannel::Enum>& channels, const QVector<float>& volumes);
+	void writeVolumes();
 
 	bool mMuted = false;
 	QVector<PwAudioChannel::Enum> mChannels;
 	QVector<float> mVolumes;
 	PwNode* node;
+
+	// Volume writes are combined so at most one is sent per interval. Until the echo of the
+	// last write arrives, volume updates from the server are held back as they are mostly
+	// echoes of earlier writes. If the echo never arrives, the last held update is applied.
+	QTimer volumeWriteTimer;
+	QTimer volumeEchoTimer;
+	bool volumeWritePending = false;
+	// cubed volumes of the last write, empty once its echo arrived
+	QVector<float> writtenVolumes;
+	QVector<float> heldVolumes;
+};
+
+// Compact storage for the property set of a node.
+//
+// Keys are interned as nearly every node shares the same small set of them, and values
+// are kept as UTF-8 until the properties are read.
+class PwNodeProperties {
+public:
+	PwNodeProperties() = default;
+	explicit PwNodeProperties(const spa_dict* dict);
+
+	[[nodiscard]] bool isEmpty() const;
+
+	// Converted on first use and cached until the properties are replaced.
+	[[nodiscard]] const QVariantMap& toVariantMap() const;
+
+	// Keys which were added, removed or changed between this and other.
+	[[nodiscard]] QVector<QString> diff(const PwNodeProperties& other) const;
+
+private:
+	struct Entry {
+		QString key;
+		QByteArray value;
+	};
+
+	static QString internKey(const char* key);
+
+	// sorted by key
+	QVector<Entry> entries;
+	mutable std::optional<QVariantMap> variantMap;
 };
 
 constexpr const char TYPE_INTERFACE_Node[] = PW_TYPE_INTERFACE_Node;             // NOLINT
@@ -148,12 +199,15 @@ class PwNode: public PwBindable<pw_node, TYPE_INTERFACE_Node, PW_VERSION_NODE> {
 public:
 	void bindHooks() override;
 	void unbindHooks() override;
+	void onUnbound() override;
 	void initProps(const spa_dict* props) override;
 
 	QString name;
 	QString description;
 	QString nick;
-	QMap<QString, QString> properties;
+	// Unlike the name this is unique, and unlike the id it is never reused.
+	quint64 serial = 0;
+	PwNodeProperties properties;
 
 	PwNodeType type = PwNodeType::Untracked;
 	bool isSink = false;
@@ -162,15 +216,22 @@ public:
 	PwNodeBoundData* boundData = nullptr;
 
 signals:
-	void propertiesChanged();
+	void propertiesChanged(const QVector<QString>& changedKeys);
+	// emitted when a link group with this node as its output or input is created
+	void linkGroupAdded(PwLinkGroup* group);
 
 private:
+	void updateProperties(const PwNodeProperties& properties);
+	void updateParam(quint32 id, quint32 index, const QByteArray& param);
+
 	static const pw_node_events EVENTS;
 	static void onInfo(void* data, const pw_node_info* info);
 	static void
 	onParam(void* data, qint32 seq, quint32 id, quint32 index, quint32 next, const spa_pod* param);
 
 	SpaHook listener;
+
+	friend class TestGraphReplay;
 };
 
 } // namespace qs::service::pipewire
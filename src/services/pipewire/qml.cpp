@@ -137,24 +137,19 @@ void PwNodeLinkTracker::setNode(PwNodeIface* node) {
 	if (node == this->mNode) return;
 
 	if (this->mNode != nullptr) {
-		if (node == nullptr) {
-			QObject::disconnect(&PwConnection::instance()->registry, nullptr, this, nullptr);
-		}
-
 		QObject::disconnect(this->mNode, nullptr, this, nullptr);
+		QObject::disconnect(this->mNode->node(), nullptr, this, nullptr);
 	}
 
 	if (node != nullptr) {
-		if (this->mNode == nullptr) {
-			QObject::connect(
-			    &PwConnection::instance()->registry,
-			    &PwRegistry::linkGroupAdded,
-			    this,
-			    &PwNodeLinkTracker::onLinkGroupCreated
-			);
-		}
-
 		QObject::connect(node, &QObject::destroyed, this, &PwNodeLinkTracker::onNodeDestroyed);
+
+		QObject::connect(
+		    node->node(),
+		    &PwNode::linkGroupAdded,
+		    this,
+		    &PwNodeLinkTracker::onLinkGroupCreated
+		);
 	}
 
 	this->mNode = node;
@@ -166,26 +161,25 @@ void PwNodeLinkTracker::updateLinks() {
 	// done first to avoid unref->reref of nodes
 	auto newLinks = QVector<PwLinkGroupIface*>();
 	if (this->mNode != nullptr) {
-		auto* connection = PwConnection::instance();
-
-		for (auto* link: connection->registry.linkGroups) {
-			if ((!this->mNode->isSink() && link->outputNode() == this->mNode->id())
-			    || (this->mNode->isSink() && link->inputNode() == this->mNode->id()))
-			{
-				auto* iface = PwLinkGroupIface::instance(link);
-
-				// do not connect twice
-				if (!this->mLinkGroups.contains(iface)) {
-					QObject::connect(
-					    iface,
-					    &QObject::destroyed,
-					    this,
-					    &PwNodeLinkTracker::onLinkGroupDestroyed
-					);
-				}
-
-				newLinks.push_back(iface);
+		auto& registry = PwConnection::instance()->registry;
+
+		const auto& groups = this->mNode->isSink() ? registry.inputLinkGroups
+		                                           : registry.outputLinkGroups;
+
+		for (auto* link: groups.value(this->mNode->id())) {
+			auto* iface = PwLinkGroupIface::instance(link);
+
+			// do not connect twice
+			if (!this->mLinkGroups.contains(iface)) {
+				QObject::connect(
+				    iface,
+				    &QObject::destroyed,
+				    this,
+				    &PwNodeLinkTracker::onLinkGroupDestroyed
+				);
 			}
+
+			newLinks.push_back(iface);
 		}
 	}
 
@@ -291,14 +285,7 @@ bool PwNodeIface::isSink() const { return this->mNode->isSink; }
 
 bool PwNodeIface::isStream() const { return this->mNode->isStream; }
 
-QVariantMap PwNodeIface::properties() const {
-	auto map = QVariantMap();
-	for (auto [k, v]: this->mNode->properties.asKeyValueRange()) {
-		map.insert(k, QVariant::fromValue(v));
-	}
-
-	return map;
-}
+QVariantMap PwNodeIface::properties() const { return this->mNode->properties.toVariantMap(); }
 
 PwNodeAudioIface* PwNodeIface::audio() const { return this->audioIface; }
 
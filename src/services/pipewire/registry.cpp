@@ -1,5 +1,7 @@
 #include "registry.hpp"
 #include <cstring>
+#include <memory>
+#include <mutex>
 
 #include <pipewire/core.h>
 #include <pipewire/extensions/metadata.h>
@@ -9,6 +11,7 @@
 #include <qdebug.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
+#include <qbytearray.h>
 #include <qobject.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
@@ -47,9 +50,11 @@ void PwBindableObject::safeDestroy() {
 
 void PwBindableObject::debugId(QDebug& debug) const {
 	auto saver = QDebugStateSaver(debug);
-	debug.nospace() << this->id << "/" << (this->object == nullptr ? "unbound" : "bound");
+	debug.nospace() << this->id << "/" << (this->bound ? "bound" : "unbound");
 }
 
+PwCore* PwBindableObject::core() const { return this->registry->core; }
+
 void PwBindableObject::ref() {
 	this->refcount++;
 	if (this->refcount == 1) this->bind();
@@ -60,17 +65,21 @@ void PwBindableObject::unref() {
 	if (this->refcount == 0) this->unbind();
 }
 
-void PwBindableObject::bind() {
-	qCDebug(logRegistry) << "Bound object" << this;
-	this->bindHooks();
-}
+void PwBindableObject::bind() { qCDebug(logRegistry) << "Bound object" << this; }
 
 void PwBindableObject::unbind() {
-	if (this->object == nullptr) return;
+	if (!this->bound) return;
 	qCDebug(logRegistry) << "Unbinding object" << this;
-	this->unbindHooks();
-	pw_proxy_destroy(this->object);
+
+	{
+		auto guard = std::lock_guard(*this->core());
+		this->unbindHooks();
+		if (this->object != nullptr) pw_proxy_destroy(this->object);
+	}
+
 	this->object = nullptr;
+	this->bound = false;
+	this->onUnbound();
 }
 
 QDebug operator<<(QDebug debug, const PwBindableObject* object) {
@@ -114,6 +123,8 @@ void PwBindableObjectRef::onObjectDestroyed() {
 }
 
 void PwRegistry::init(PwCore& core) {
+	this->core = &core;
+	auto guard = std::lock_guard(core);
 	this->object = pw_core_get_registry(core.core, PW_VERSION_REGISTRY, 0);
 	pw_registry_add_listener(this->object, &this->listener.hook, &PwRegistry::EVENTS, this);
 }
@@ -134,60 +145,110 @@ void PwRegistry::onGlobal(
 ) {
 	auto* self = static_cast<PwRegistry*>(data);
 
+	// most globals are ports and clients, which don't need to reach the GUI thread
+	if (strcmp(type, PW_TYPE_INTERFACE_Metadata) != 0 && strcmp(type, PW_TYPE_INTERFACE_Link) != 0
+	    && strcmp(type, PW_TYPE_INTERFACE_Node) != 0)
+	{
+		return;
+	}
+
+	auto typeStr = QByteArray(type);
+	auto propsCopy = std::make_shared<PwDictCopy>(props);
+
+	self->core->post(0, [=]() {
+		self->addGlobal(id, permissions, typeStr.constData(), propsCopy->dict());
+	});
+}
+
+void PwRegistry::onGlobalRemoved(void* data, quint32 id) {
+	auto* self = static_cast<PwRegistry*>(data);
+	self->core->post(0, [=]() { self->removeGlobal(id); });
+}
+
+void PwRegistry::addGlobal(
+    quint32 id,
+    quint32 permissions,
+    const char* type,
+    const spa_dict* props
+) {
 	if (strcmp(type, PW_TYPE_INTERFACE_Metadata) == 0) {
 		auto* meta = new PwMetadata();
-		meta->init(self, id, permissions);
+		meta->init(this, id, permissions);
 		meta->initProps(props);
 
-		self->metadata.emplace(id, meta);
+		this->metadata.emplace(id, meta);
 		meta->bind();
 	} else if (strcmp(type, PW_TYPE_INTERFACE_Link) == 0) {
 		auto* link = new PwLink();
-		link->init(self, id, permissions);
+		link->init(this, id, permissions);
 		link->initProps(props);
 
-		self->links.emplace(id, link);
-		self->addLinkToGroup(link);
-		emit self->linkAdded(link);
+		this->links.emplace(id, link);
+		this->addLinkToGroup(link);
+		emit this->linkAdded(link);
 	} else if (strcmp(type, PW_TYPE_INTERFACE_Node) == 0) {
 		auto* node = new PwNode();
-		node->init(self, id, permissions);
+		node->init(this, id, permissions);
 		node->initProps(props);
 
-		self->nodes.emplace(id, node);
-		emit self->nodeAdded(node);
+		this->nodes.emplace(id, node);
+		emit this->nodeAdded(node);
 	}
 }
 
-void PwRegistry::onGlobalRemoved(void* data, quint32 id) {
-	auto* self = static_cast<PwRegistry*>(data);
-
-	if (auto* meta = self->metadata.value(id)) {
-		self->metadata.remove(id);
+void PwRegistry::removeGlobal(quint32 id) {
+	if (auto* meta = this->metadata.value(id)) {
+		this->metadata.remove(id);
 		meta->safeDestroy();
-	} else if (auto* link = self->links.value(id)) {
-		self->links.remove(id);
+	} else if (auto* link = this->links.value(id)) {
+		this->links.remove(id);
 		link->safeDestroy();
-	} else if (auto* node = self->nodes.value(id)) {
-		self->nodes.remove(id);
+	} else if (auto* node = this->nodes.value(id)) {
+		this->nodes.remove(id);
 		node->safeDestroy();
 	}
 }
 
 void PwRegistry::addLinkToGroup(PwLink* link) {
-	for (auto* group: this->linkGroups) {
-		if (group->tryAddLink(link)) return;
+	auto outputNode = link->outputNode();
+	auto inputNode = link->inputNode();
+
+	if (auto* group = this->linkGroups.value({outputNode, inputNode})) {
+		group->tryAddLink(link);
+		return;
 	}
 
 	auto* group = new PwLinkGroup(link);
-	QObject::connect(group, &QObject::destroyed, this, &PwRegistry::onLinkGroupDestroyed);
-	this->linkGroups.push_back(group);
+
+	QObject::connect(group, &QObject::destroyed, this, [=, this]() {
+		this->removeLinkGroup(group, outputNode, inputNode);
+	});
+
+	this->linkGroups.insert({outputNode, inputNode}, group);
+	this->outputLinkGroups[outputNode].push_back(group);
+	this->inputLinkGroups[inputNode].push_back(group);
+
 	emit this->linkGroupAdded(group);
+
+	if (auto* node = this->nodes.value(outputNode)) emit node->linkGroupAdded(group);
+	if (inputNode != outputNode) {
+		if (auto* node = this->nodes.value(inputNode)) emit node->linkGroupAdded(group);
+	}
 }
 
-void PwRegistry::onLinkGroupDestroyed(QObject* object) {
-	auto* group = static_cast<PwLinkGroup*>(object); // NOLINT
-	this->linkGroups.removeOne(group);
+void PwRegistry::removeLinkGroup(PwLinkGroup* group, quint32 outputNode, quint32 inputNode) {
+	this->linkGroups.remove({outputNode, inputNode});
+
+	auto removeFrom = [group](QHash<quint32, QVector<PwLinkGroup*>>& index, quint32 node) {
+		auto iter = index.find(node);
+		if (iter == index.end()) return;
+
+		iter->removeOne(group);
+		if (iter->isEmpty()) index.erase(iter);
+	};
+
+	removeFrom(this->outputLinkGroups, outputNode);
+	removeFrom(this->inputLinkGroups, inputNode);
 }
 
 } // namespace qs::service::pipewire
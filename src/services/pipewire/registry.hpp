@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include <pipewire/core.h>
 #include <pipewire/proxy.h>
 #include <qcontainerfwd.h>
@@ -7,6 +9,7 @@
 #include <qhash.h>
 #include <qloggingcategory.h>
 #include <qobject.h>
+#include <qpair.h>
 #include <qtclasshelpermacros.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
@@ -40,6 +43,7 @@ public:
 	quint32 perms = 0;
 
 	void debugId(QDebug& debug) const;
+	[[nodiscard]] PwCore* core() const;
 	void ref();
 	void unref();
 
@@ -50,10 +54,16 @@ signals:
 protected:
 	virtual void bind();
 	void unbind();
+	// Add and remove proxy listeners. Called with the pipewire loop locked, so they must not
+	// emit signals.
 	virtual void bindHooks() {};
 	virtual void unbindHooks() {};
+	// Resets state that was only valid while bound. Called after unbinding with the loop unlocked.
+	virtual void onUnbound() {};
 
 	quint32 refcount = 0;
+	// Kept apart from the proxy so tests can replay events into bound objects without a server.
+	bool bound = false;
 	pw_proxy* object = nullptr;
 	PwRegistry* registry = nullptr;
 };
@@ -69,10 +79,17 @@ public:
 
 protected:
 	void bind() override {
-		if (this->object != nullptr) return;
-		auto* object =
-		    pw_registry_bind(this->registry->object, this->id, INTERFACE, VERSION, 0); // NOLINT
-		this->object = static_cast<pw_proxy*>(object);
+		if (this->bound) return;
+
+		{
+			auto guard = std::lock_guard(*this->core());
+			auto* object =
+			    pw_registry_bind(this->registry->object, this->id, INTERFACE, VERSION, 0); // NOLINT
+			this->object = static_cast<pw_proxy*>(object);
+			this->bound = true;
+			this->bindHooks();
+		}
+
 		this->PwBindableObject::bind();
 	}
 
@@ -117,11 +134,17 @@ class PwRegistry
 public:
 	void init(PwCore& core);
 
+	PwCore* core = nullptr;
+
 	//QHash<quint32, PwClient*> clients;
 	QHash<quint32, PwMetadata*> metadata;
 	QHash<quint32, PwNode*> nodes;
 	QHash<quint32, PwLink*> links;
-	QVector<PwLinkGroup*> linkGroups;
+	// keyed by (output node, input node)
+	QHash<QPair<quint32, quint32>, PwLinkGroup*> linkGroups;
+	// link groups by the id of their output or input node
+	QHash<quint32, QVector<PwLinkGroup*>> outputLinkGroups;
+	QHash<quint32, QVector<PwLinkGroup*>> inputLinkGroups;
 
 signals:
 	void nodeAdded(PwNode* node);
@@ -135,9 +158,6 @@ signals:
 	    const char* value
 	);
 
-private slots:
-	void onLinkGroupDestroyed(QObject* object);
-
 private:
 	static const pw_registry_events EVENTS;
 
@@ -152,9 +172,15 @@ private:
 
 	static void onGlobalRemoved(void* data, quint32 id);
 
+	void addGlobal(quint32 id, quint32 permissions, const char* type, const spa_dict* props);
+	void removeGlobal(quint32 id);
+
 	void addLinkToGroup(PwLink* link);
+	void removeLinkGroup(PwLinkGroup* group, quint32 outputNode, quint32 inputNode);
 
 	SpaHook listener;
+
+	friend class TestGraphReplay;
 };
 
 } // namespace qs::service::pipewire
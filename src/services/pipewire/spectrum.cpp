@@ -0,0 +1,244 @@
+#include "spectrum.hpp"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <numbers>
+
+#include <qcontainerfwd.h>
+#include <qobject.h>
+#include <qstring.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+
+#include "capture.hpp"
+
+namespace qs::service::pipewire {
+
+namespace {
+
+// ~43ms of audio at 48kHz, giving ~23Hz of frequency resolution.
+constexpr qsizetype FFT_SIZE = 2048;
+
+// range of the dBFS scale mapped to 0-1 in the output
+constexpr float DB_RANGE = 60;
+
+} // namespace
+
+PwSpectrumCapture::PwSpectrumCapture()
+    : history(FFT_SIZE)
+    , window(FFT_SIZE)
+    , bitReversed(FFT_SIZE)
+    , twiddles(FFT_SIZE / 2)
+    , fft(FFT_SIZE)
+    , magnitudes(FFT_SIZE / 2 + 1) {
+	// Everything used by the FFT is precomputed here so the capture thread never allocates.
+	qsizetype bits = 0;
+	while ((qsizetype(1) << bits) < FFT_SIZE) bits++;
+
+	for (qsizetype i = 0; i != FFT_SIZE; i++) {
+		qsizetype reversed = 0;
+		for (qsizetype bit = 0; bit != bits; bit++) {
+			reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+		}
+
+		this->bitReversed[i] = reversed;
+
+		// hann window
+		auto phase = 2 * std::numbers::pi_v<float> * static_cast<float>(i) / (FFT_SIZE - 1);
+		this->window[i] = 0.5f * (1 - std::cos(phase));
+	}
+
+	for (qsizetype i = 0; i != FFT_SIZE / 2; i++) {
+		auto phase = -2 * std::numbers::pi_v<float> * static_cast<float>(i) / FFT_SIZE;
+		this->twiddles[i] = std::polar(1.0f, phase);
+	}
+}
+
+PwSpectrumCapture::~PwSpectrumCapture() { this->stop(); }
+
+void PwSpectrumCapture::onFormat(quint32 /*channels*/, quint32 rate) {
+	auto msecs = static_cast<quint64>(this->windowMsecs.load(std::memory_order_relaxed));
+	this->windowFrames = std::max(static_cast<quint32>(rate * msecs / 1000), 1u);
+	this->accumulatedFrames = 0;
+	this->historyIndex = 0;
+	std::ranges::fill(this->history, 0);
+	this->smoothed.fill(0);
+}
+
+void PwSpectrumCapture::onSamples(const float* samples, quint32 frames) {
+	auto channels = this->channels;
+	auto scale = 1.0f / static_cast<float>(channels);
+
+	// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+	for (quint32 frame = 0; frame != frames; frame++) {
+		const auto* frameSamples = samples + static_cast<qsizetype>(frame) * channels;
+
+		// the spectrum is computed over a mono downmix
+		float sum = 0;
+		for (quint32 channel = 0; channel != channels; channel++) {
+			sum += frameSamples[channel];
+		}
+
+		this->history[this->historyIndex] = sum * scale;
+		this->historyIndex = (this->historyIndex + 1) % FFT_SIZE;
+
+		this->accumulatedFrames++;
+		if (this->accumulatedFrames >= this->windowFrames) {
+			this->analyze();
+			this->accumulatedFrames = 0;
+
+			auto msecs = static_cast<quint64>(this->windowMsecs.load(std::memory_order_relaxed));
+			this->windowFrames = std::max(static_cast<quint32>(this->rate * msecs / 1000), 1u);
+		}
+	}
+	// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+void PwSpectrumCapture::transform() {
+	// load the history oldest sample first, windowed and in bit reversed order
+	for (qsizetype i = 0; i != FFT_SIZE; i++) {
+		auto sample = this->history[(this->historyIndex + i) % FFT_SIZE] * this->window[i];
+		this->fft[this->bitReversed[i]] = sample;
+	}
+
+	// iterative radix-2 cooley-tukey
+	for (qsizetype size = 2; size <= FFT_SIZE; size *= 2) {
+		auto half = size / 2;
+		auto step = FFT_SIZE / size;
+
+		for (qsizetype start = 0; start < FFT_SIZE; start += size) {
+			for (qsizetype k = 0; k != half; k++) {
+				auto t = this->twiddles[k * step] * this->fft[start + k + half];
+				auto u = this->fft[start + k];
+				this->fft[start + k] = u + t;
+				this->fft[start + k + half] = u - t;
+			}
+		}
+	}
+
+	// scale to the amplitude of a full scale sine, accounting for the window's gain
+	auto scale = 4.0f / FFT_SIZE;
+	for (qsizetype i = 0; i != FFT_SIZE / 2 + 1; i++) {
+		this->magnitudes[i] = std::abs(this->fft[i]) * scale;
+	}
+}
+
+void PwSpectrumCapture::analyze() {
+	this->transform();
+
+	auto bins =
+	    std::clamp(this->bins.load(std::memory_order_relaxed), 1, qint32(SPECTRUM_MAX_BINS));
+	auto smoothing = std::clamp(this->smoothing.load(std::memory_order_relaxed), 0.0f, 1.0f);
+	auto nyquist = static_cast<float>(this->rate) / 2;
+	auto minFrequency =
+	    std::clamp(this->minFrequency.load(std::memory_order_relaxed), 1.0f, nyquist);
+	auto maxFrequency =
+	    std::clamp(this->maxFrequency.load(std::memory_order_relaxed), minFrequency, nyquist);
+
+	auto resolution = static_cast<float>(this->rate) / FFT_SIZE;
+	auto ratio = maxFrequency / minFrequency;
+	auto lastBin = FFT_SIZE / 2;
+
+	auto& frame = this->spectrum.writeBuffer();
+	frame.bins = static_cast<quint32>(bins);
+
+	for (qint32 bin = 0; bin != bins; bin++) {
+		// log spaced band edges
+		auto low = minFrequency * std::pow(ratio, static_cast<float>(bin) / bins);
+		auto high = minFrequency * std::pow(ratio, static_cast<float>(bin + 1) / bins);
+
+		auto first = std::clamp(static_cast<qsizetype>(low / resolution), qsizetype(0), lastBin);
+		auto last = std::clamp(
+		    static_cast<qsizetype>(std::ceil(high / resolution)),
+		    first + 1,
+		    lastBin + 1
+		);
+
+		float peak = 0;
+		for (auto i = first; i != last; i++) {
+			peak = std::max(peak, this->magnitudes[i]);
+		}
+
+		auto db = 20 * std::log10(std::max(peak, 1e-9f));
+		auto level = std::clamp((db + DB_RANGE) / DB_RANGE, 0.0f, 1.0f);
+
+		auto& value = this->smoothed[bin];
+		value = value * smoothing + level * (1 - smoothing);
+		frame.values[bin] = value;
+	}
+
+	this->spectrum.publish();
+}
+
+PwSpectrumAnalyzer::PwSpectrumAnalyzer(QObject* parent): PwNodeCaptureConsumer(parent) {}
+
+PwAudioCapture& PwSpectrumAnalyzer::audioCapture() { return this->capture; }
+QString PwSpectrumAnalyzer::streamName() const { return "quickshell-spectrum-analyzer"; }
+
+void PwSpectrumAnalyzer::onUpdateIntervalChanged() {
+	this->capture.windowMsecs.store(this->updateInterval(), std::memory_order_relaxed);
+}
+
+qint32 PwSpectrumAnalyzer::bins() const {
+	return this->capture.bins.load(std::memory_order_relaxed);
+}
+
+void PwSpectrumAnalyzer::setBins(qint32 bins) {
+	bins = std::clamp(bins, 1, qint32(SPECTRUM_MAX_BINS));
+	if (bins == this->bins()) return;
+	this->capture.bins.store(bins, std::memory_order_relaxed);
+	emit this->binsChanged();
+}
+
+float PwSpectrumAnalyzer::minFrequency() const {
+	return this->capture.minFrequency.load(std::memory_order_relaxed);
+}
+
+void PwSpectrumAnalyzer::setMinFrequency(float minFrequency) {
+	if (minFrequency == this->minFrequency()) return;
+	this->capture.minFrequency.store(minFrequency, std::memory_order_relaxed);
+	emit this->minFrequencyChanged();
+}
+
+float PwSpectrumAnalyzer::maxFrequency() const {
+	return this->capture.maxFrequency.load(std::memory_order_relaxed);
+}
+
+void PwSpectrumAnalyzer::setMaxFrequency(float maxFrequency) {
+	if (maxFrequency == this->maxFrequency()) return;
+	this->capture.maxFrequency.store(maxFrequency, std::memory_order_relaxed);
+	emit this->maxFrequencyChanged();
+}
+
+float PwSpectrumAnalyzer::smoothing() const {
+	return this->capture.smoothing.load(std::memory_order_relaxed);
+}
+
+void PwSpectrumAnalyzer::setSmoothing(float smoothing) {
+	smoothing = std::clamp(smoothing, 0.0f, 1.0f);
+	if (smoothing == this->smoothing()) return;
+	this->capture.smoothing.store(smoothing, std::memory_order_relaxed);
+	emit this->smoothingChanged();
+}
+
+QVector<float> PwSpectrumAnalyzer::values() const { return this->mValues; }
+
+bool PwSpectrumAnalyzer::publishResults() {
+	if (!this->capture.spectrum.update()) return false;
+
+	const auto& frame = this->capture.spectrum.readBuffer();
+	auto values = QVector<float>(frame.values.begin(), frame.values.begin() + frame.bins);
+
+	if (values == this->mValues) return true;
+	this->mValues = values;
+	emit this->valuesChanged();
+	return true;
+}
+
+void PwSpectrumAnalyzer::clearResults() {
+	if (this->mValues.isEmpty()) return;
+	this->mValues.clear();
+	emit this->valuesChanged();
+}
+
+} // namespace qs::service::pipewire
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <complex>
+#include <vector>
+
+#include <qcontainerfwd.h>
+#include <qobject.h>
+#include <qqmlintegration.h>
+#include <qstring.h>
+#include <qtclasshelpermacros.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+
+#include "../../core/triplebuffer.hpp"
+#include "capture.hpp"
+
+namespace qs::service::pipewire {
+
+constexpr qsizetype SPECTRUM_MAX_BINS = 256;
+
+struct PwSpectrumFrame {
+	quint32 bins = 0;
+	std::array<float, SPECTRUM_MAX_BINS> values {};
+};
+
+class PwSpectrumCapture: public PwAudioCapture {
+public:
+	PwSpectrumCapture();
+	~PwSpectrumCapture() override;
+	Q_DISABLE_COPY_MOVE(PwSpectrumCapture);
+
+	// settings may be changed from any thread and apply from the next analysis
+	std::atomic<qint32> windowMsecs = 16;
+	std::atomic<qint32> bins = 32;
+	std::atomic<float> minFrequency = 50;
+	std::atomic<float> maxFrequency = 12000;
+	std::atomic<float> smoothing = 0.7;
+
+	TripleBuffer<PwSpectrumFrame> spectrum;
+
+protected:
+	void onFormat(quint32 channels, quint32 rate) override;
+	void onSamples(const float* samples, quint32 frames) override;
+
+private:
+	void analyze();
+	void transform();
+
+	quint32 windowFrames = 0;
+	quint32 accumulatedFrames = 0;
+	qsizetype historyIndex = 0;
+	std::vector<float> history;
+	std::vector<float> window;
+	std::vector<qsizetype> bitReversed;
+	std::vector<std::complex<float>> twiddles;
+	std::vector<std::complex<float>> fft;
+	std::vector<float> magnitudes;
+	std::array<float, SPECTRUM_MAX_BINS> smoothed {};
+};
+
+///! Audio spectrum of a pipewire node.
+/// Computes the frequency spectrum of the audio passing through a node, for use in
+/// audio visualizers.
+///
+/// The spectrum is computed using a windowed FFT, and grouped into @@bins logarithmically
+/// spaced frequency bands between @@minFrequency and @@maxFrequency.
+/// See @@PwNodeCaptureConsumer for the properties controlling capture.
+///
+/// #### Example
+/// ```qml
+/// PwSpectrumAnalyzer {
+///   id: spectrum
+///   node: Pipewire.defaultAudioSink
+///   bins: 24
+/// }
+///
+/// Row {
+///   Repeater {
+///     model: spectrum.values
+///
+///     Rectangle {
+///       required property real modelData
+///       anchors.bottom: parent.bottom
+///       width: 6
+///       height: 40 * modelData
+///     }
+///   }
+/// }
+/// ```
+class PwSpectrumAnalyzer: public PwNodeCaptureConsumer {
+	Q_OBJECT;
+	// clang-format off
+	/// The number of frequency bands to group the spectrum into. Defaults to 32, maximum 256.
+	Q_PROPERTY(qint32 bins READ bins WRITE setBins NOTIFY binsChanged);
+	/// The lower bound of the lowest frequency band in Hz. Defaults to 50.
+	Q_PROPERTY(float minFrequency READ minFrequency WRITE setMinFrequency NOTIFY minFrequencyChanged);
+	/// The upper bound of the highest frequency band in Hz. Defaults to 12000.
+	Q_PROPERTY(float maxFrequency READ maxFrequency WRITE setMaxFrequency NOTIFY maxFrequencyChanged);
+	/// How much of the previous value is kept in each update, between 0 and 1. Defaults to 0.7.
+	///
+	/// Higher values give smoother but less responsive output.
+	Q_PROPERTY(float smoothing READ smoothing WRITE setSmoothing NOTIFY smoothingChanged);
+	/// The level of each frequency band, from low to high frequency.
+	///
+	/// Levels range from 0 to 1, mapped linearly from -60dB to 0dB of full scale.
+	Q_PROPERTY(QVector<float> values READ values NOTIFY valuesChanged);
+	// clang-format on
+	QML_ELEMENT;
+
+public:
+	explicit PwSpectrumAnalyzer(QObject* parent = nullptr);
+
+	[[nodiscard]] qint32 bins() const;
+	void setBins(qint32 bins);
+
+	[[nodiscard]] float minFrequency() const;
+	void setMinFrequency(float minFrequency);
+
+	[[nodiscard]] float maxFrequency() const;
+	void setMaxFrequency(float maxFrequency);
+
+	[[nodiscard]] float smoothing() const;
+	void setSmoothing(float smoothing);
+
+	[[nodiscard]] QVector<float> values() const;
+
+signals:
+	void binsChanged();
+	void minFrequencyChanged();
+	void maxFrequencyChanged();
+	void smoothingChanged();
+	void valuesChanged();
+
+protected:
+	[[nodiscard]] PwAudioCapture& audioCapture() override;
+	[[nodiscard]] QString streamName() const override;
+	bool publishResults() override;
+	void clearResults() override;
+	void onUpdateIntervalChanged() override;
+
+private:
+	QVector<float> mValues;
+	PwSpectrumCapture capture;
+};
+
+} // namespace qs::service::pipewire
@@ -0,0 +1,260 @@
+#include "graphreplay.hpp"
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <pipewire/node.h>
+#include <pipewire/type.h>
+#include <qbytearray.h>
+#include <qcoreapplication.h>
+#include <qelapsedtimer.h>
+#include <qlist.h>
+#include <qlogging.h>
+#include <qobject.h>
+#include <qstring.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qtypes.h>
+#include <spa/param/audio/raw.h>
+#include <spa/param/param.h>
+#include <spa/param/props.h>
+#include <spa/pod/builder.h>
+#include <spa/pod/vararg.h>
+#include <spa/utils/dict.h>
+#include <spa/utils/type.h>
+
+#include "../core.hpp"
+#include "../node.hpp"
+#include "../registry.hpp"
+
+namespace qs::service::pipewire {
+
+namespace {
+
+using Props = std::unique_ptr<PwDictCopy>;
+
+// Builds props from key value pairs. PwDictCopy owns the strings, so the pairs may be temporary.
+Props makeProps(const QList<std::pair<QByteArray, QByteArray>>& entries) {
+	auto items = std::vector<spa_dict_item>();
+
+	for (const auto& [key, value]: entries) {
+		items.push_back({.key = key.constData(), .value = value.constData()});
+	}
+
+	auto dict = spa_dict {
+	    .flags = 0,
+	    .n_items = static_cast<quint32>(items.size()),
+	    .items = items.data(),
+	};
+	return std::make_unique<PwDictCopy>(&dict);
+}
+
+// Roughly the property set pw-dump reports for an alsa sink or a client stream.
+Props nodeProps(quint32 index, bool sink, quint32 latency) {
+	auto name = QByteArray::number(index);
+
+	return makeProps({
+	    {"media.class", sink ? "Audio/Sink" : "Stream/Output/Audio"},
+	    {"node.name", "replay-node-" + name},
+	    {"node.description", "Replay Node " + name},
+	    {"node.nick", "Node " + name},
+	    {"object.serial", QByteArray::number(1000 + index)},
+	    {"object.path", "replay:" + name},
+	    {"factory.id", "18"},
+	    {"client.id", "42"},
+	    {"device.id", "51"},
+	    {"priority.session", "1000"},
+	    {"priority.driver", "1000"},
+	    {"audio.channels", "2"},
+	    {"audio.rate", "48000"},
+	    {"audio.position", "FL,FR"},
+	    {"api.alsa.path", "front:0"},
+	    {"api.alsa.pcm.card", "0"},
+	    {"application.name", "Replay"},
+	    {"media.name", "Replay Stream " + name},
+	    {"node.rate", "1/48000"},
+	    {"node.latency", QByteArray::number(latency) + "/48000"},
+	});
+}
+
+Props linkProps(quint32 output, quint32 input) {
+	return makeProps({
+	    {"link.output.node", QByteArray::number(output)},
+	    {"link.input.node", QByteArray::number(input)},
+	});
+}
+
+} // namespace
+
+void TestGraphReplay::replay_data() { // NOLINT
+	QTest::addColumn<quint32>("nodes");
+	QTest::addColumn<quint32>("rounds");
+
+	// NOLINTBEGIN
+	QTest::addRow("10-nodes") << 10u << 10u;
+	QTest::addRow("100-nodes") << 100u << 10u;
+	QTest::addRow("1000-nodes") << 1000u << 10u;
+	// NOLINTEND
+}
+
+void TestGraphReplay::replay() {
+	// NOLINTBEGIN
+	QFETCH(quint32, nodes);
+	QFETCH(quint32, rounds);
+	// NOLINTEND
+
+	auto core = PwCore(nullptr, false);
+	auto registry = PwRegistry();
+	registry.core = &core;
+
+	// sinks are the first half of the node ids, streams the second half
+	auto sinks = nodes / 2;
+	auto streams = nodes - sinks;
+	auto nodeId = [](quint32 index) { return 100 + index; };
+	auto linkId = [&](quint32 index) { return 100 + nodes + index; };
+
+	qsizetype nodesAdded = 0;
+	qsizetype linkGroupsAdded = 0;
+	qsizetype propertyUpdates = 0;
+	qsizetype volumeUpdates = 0;
+	QObject::connect(&registry, &PwRegistry::nodeAdded, &registry, [&](PwNode* node) {
+		nodesAdded++;
+
+		QObject::connect(node, &PwNode::propertiesChanged, node, [&]() { propertyUpdates++; });
+
+		auto* audio = dynamic_cast<PwNodeBoundAudio*>(node->boundData);
+		QVERIFY(audio != nullptr);
+		QObject::connect(audio, &PwNodeBoundAudio::volumesChanged, node, [&]() { volumeUpdates++; });
+	});
+
+	QObject::connect(&registry, &PwRegistry::linkGroupAdded, &registry, [&]() {
+		linkGroupsAdded++;
+	});
+
+	auto timer = QElapsedTimer();
+	auto dispatch = [&](const char* phase, qsizetype events) {
+		QCoreApplication::processEvents();
+		auto nsecs = timer.nsecsElapsed();
+		qInfo() << phase << "-" << events << "events in" << nsecs / 1000 << "us,"
+		        << (events == 0 ? 0 : nsecs / events) << "ns per event";
+	};
+
+	// globals. each stream gets two links (one per channel) to a sink
+	timer.start();
+
+	for (quint32 i = 0; i != nodes; i++) {
+		auto props = nodeProps(i, i < sinks, 0);
+		PwRegistry::onGlobal(&registry, nodeId(i), 0, PW_TYPE_INTERFACE_Node, 0, props->dict());
+	}
+
+	for (quint32 i = 0; i != streams * 2; i++) {
+		auto props = linkProps(nodeId(sinks + i / 2), nodeId(sinks == 0 ? 0 : (i / 2) % sinks));
+		PwRegistry::onGlobal(&registry, linkId(i), 0, PW_TYPE_INTERFACE_Link, 0, props->dict());
+	}
+
+	dispatch("globals", nodes + streams * 2);
+
+	QCOMPARE(nodesAdded, qsizetype(nodes));
+	QCOMPARE(registry.nodes.size(), qsizetype(nodes));
+	QCOMPARE(registry.links.size(), qsizetype(streams * 2));
+	QCOMPARE(linkGroupsAdded, qsizetype(sinks == 0 ? 0 : streams));
+
+	// Nodes only receive info and params while bound. Binding needs a server, so nodes are
+	// marked bound without a proxy.
+	for (auto* node: registry.nodes.values()) {
+		node->bound = true;
+	}
+
+	auto podBuffer = std::array<quint32, 1024>();
+	auto sendInfo = [&](quint32 latency) {
+		for (quint32 i = 0; i != nodes; i++) {
+			auto props = nodeProps(i, i < sinks, latency);
+			auto info = pw_node_info();
+			info.id = nodeId(i);
+			info.change_mask = PW_NODE_CHANGE_MASK_PROPS;
+			info.props = const_cast<spa_dict*>(props->dict()); // NOLINT
+
+			PwNode::onInfo(registry.nodes.value(nodeId(i)), &info);
+		}
+	};
+
+	auto sendParams = [&](float volume) {
+		auto volumes = std::array<float, 2> {volume, volume};
+		auto channels = std::array<quint32, 2> {SPA_AUDIO_CHANNEL_FL, SPA_AUDIO_CHANNEL_FR};
+
+		for (quint32 i = 0; i != nodes; i++) {
+			auto builder = SPA_POD_BUILDER_INIT(podBuffer.data(), podBuffer.size());
+
+			// clang-format off
+			auto* pod = spa_pod_builder_add_object(
+					&builder, SPA_TYPE_OBJECT_Props, SPA_PARAM_Props,
+					SPA_PROP_channelVolumes, SPA_POD_Array(sizeof(float), SPA_TYPE_Float, quint32(volumes.size()), volumes.data()),
+					SPA_PROP_channelMap, SPA_POD_Array(sizeof(quint32), SPA_TYPE_Id, quint32(channels.size()), channels.data()),
+					SPA_PROP_mute, SPA_POD_Bool(false)
+			);
+			// clang-format on
+
+			auto* node = registry.nodes.value(nodeId(i));
+			PwNode::onParam(node, 0, SPA_PARAM_Props, 0, 0, static_cast<spa_pod*>(pod));
+		}
+	};
+
+	// a burst of updates for every node should reach the GUI thread once per node
+	timer.start();
+
+	for (quint32 round = 0; round != rounds; round++) {
+		sendInfo(256 + round);
+		sendParams(0.1f * static_cast<float>(round % 10));
+	}
+
+	dispatch("update burst", static_cast<qsizetype>(nodes) * rounds * 2);
+
+	QCOMPARE(propertyUpdates, qsizetype(nodes));
+	QCOMPARE(volumeUpdates, qsizetype(nodes));
+
+	for (auto* node: registry.nodes.values()) {
+		auto latency = node->properties.toVariantMap().value("node.latency").toString();
+		QCOMPARE(latency, QString("%1/48000").arg(256 + rounds - 1));
+	}
+
+	// unchanged updates should not notify
+	propertyUpdates = 0;
+	volumeUpdates = 0;
+	timer.start();
+
+	sendInfo(256 + rounds - 1);
+	sendParams(0.1f * static_cast<float>((rounds - 1) % 10));
+
+	dispatch("unchanged updates", static_cast<qsizetype>(nodes) * 2);
+
+	QCOMPARE(propertyUpdates, qsizetype(0));
+	QCOMPARE(volumeUpdates, qsizetype(0));
+
+	// removal unbinds the nodes, which resets their properties and volumes
+	propertyUpdates = 0;
+	volumeUpdates = 0;
+	timer.start();
+
+	for (quint32 i = 0; i != streams * 2; i++) {
+		PwRegistry::onGlobalRemoved(&registry, linkId(i));
+	}
+
+	for (quint32 i = 0; i != nodes; i++) {
+		PwRegistry::onGlobalRemoved(&registry, nodeId(i));
+	}
+
+	dispatch("removal", nodes + streams * 2);
+
+	QCOMPARE(propertyUpdates, qsizetype(nodes));
+	QCOMPARE(volumeUpdates, qsizetype(nodes));
+	QVERIFY(registry.nodes.isEmpty());
+	QVERIFY(registry.links.isEmpty());
+	QVERIFY(registry.linkGroups.isEmpty());
+	QVERIFY(registry.outputLinkGroups.isEmpty());
+	QVERIFY(registry.inputLinkGroups.isEmpty());
+}
+
+} // namespace qs::service::pipewire
+
+QTEST_GUILESS_MAIN(qs::service::pipewire::TestGraphReplay);
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <qobject.h>
+#include <qtmetamacros.h>
+
+namespace qs::service::pipewire {
+
+// Replays synthetic registry, info and param event streams through the pipewire
+// callbacks without a pipewire server, checking how many model updates reach the
+// GUI thread and logging the time spent per event.
+class TestGraphReplay: public QObject {
+	Q_OBJECT;
+
+private slots:
+	static void replay_data(); // NOLINT
+	static void replay();
+};
+
+} // namespace qs::service::pipewire
@@ -7,35 +7,28 @@
 #include <qimage.h>
 #include <qlogging.h>
 #include <qmetatype.h>
-#include <qsysinfo.h>
 #include <qtypes.h>
 
 QImage DBusSniIconPixmap::createImage() const {
-	// fix byte order if on a little endian machine
-	if (QSysInfo::ByteOrder == QSysInfo::LittleEndian) {
-		auto* newbuf = new quint32[this->data.size()];
-		const auto* oldbuf = reinterpret_cast<const quint32*>(this->data.data()); // NOLINT
-
-		for (uint i = 0; i < this->data.size() / sizeof(quint32); ++i) {
-			newbuf[i] = qFromBigEndian(oldbuf[i]); // NOLINT
-		}
-
-		return QImage(
-		    reinterpret_cast<const uchar*>(newbuf), // NOLINT
-		    this->width,
-		    this->height,
-		    QImage::Format_ARGB32,
-		    [](void* ptr) { delete reinterpret_cast<quint32*>(ptr); }, // NOLINT
-		    newbuf
-		);
-	} else {
-		return QImage(
-		    reinterpret_cast<const uchar*>(this->data.data()), // NOLINT
-		    this->width,
-		    this->height,
-		    QImage::Format_ARGB32
-		);
+	if (this->width <= 0 || this->height <= 0) return QImage();
+
+	auto pixels = static_cast<qsizetype>(this->width) * this->height;
+	if (this->data.size() < pixels * static_cast<qsizetype>(sizeof(quint32))) {
+		qWarning() << "Ignoring StatusNotifierItem pixmap with too little data for its size" << *this;
+		return QImage();
 	}
+
+	auto image = QImage(this->width, this->height, QImage::Format_ARGB32);
+	if (image.isNull()) return image;
+
+	// Pixmaps are sent as big endian ARGB32. The array form of qFromBigEndian uses
+	// vectorized byte swaps where available and degrades to a copy on big endian machines.
+	// Rows of a 32 bit QImage are never padded, so the image can be filled in one go.
+	qFromBigEndian<quint32>(this->data.constData(), pixels, image.bits());
+
+	// painting and scaling are done in premultiplied form, so convert once up front
+	image.convertTo(QImage::Format_ARGB32_Premultiplied);
+	return image;
 }
 
 const QDBusArgument& operator>>(const QDBusArgument& argument, DBusSniIconPixmap& pixmap) {
@@ -10,7 +10,9 @@ struct DBusSniIconPixmap {
 	qint32 height = 0;
 	QByteArray data;
 
-	// valid only for the lifetime of the pixmap
+	[[nodiscard]] bool operator==(const DBusSniIconPixmap& other) const = default;
+
+	// Returns a premultiplied copy of the pixmap, or a null image if the pixmap is invalid.
 	[[nodiscard]] QImage createImage() const;
 };
 
@@ -21,6 +23,8 @@ struct DBusSniTooltip {
 	DBusSniIconPixmapList iconPixmaps;
 	QString title;
 	QString description;
+
+	[[nodiscard]] bool operator==(const DBusSniTooltip& other) const = default;
 };
 
 const QDBusArgument& operator>>(const QDBusArgument& argument, DBusSniIconPixmap& pixmap);
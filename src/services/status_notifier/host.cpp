@@ -12,6 +12,7 @@
 #include <unistd.h>
 
 #include "../../core/common.hpp"
+#include "../../core/model.hpp"
 #include "../../dbus/properties.hpp"
 #include "dbus_watcher_interface.h"
 #include "item.hpp"
@@ -21,6 +22,14 @@ Q_LOGGING_CATEGORY(logStatusNotifierHost, "quickshell.service.sni.host", QtWarni
 
 namespace qs::service::sni {
 
+namespace {
+
+// Maximum number of items requesting their initial properties at once. Requests are
+// pipelined on the bus, but unbounded bursts can trip rate limits in some item implementations.
+constexpr qsizetype MAX_REQUESTING_ITEMS = 8;
+
+} // namespace
+
 StatusNotifierHost::StatusNotifierHost(QObject* parent): QObject(parent) {
 	StatusNotifierWatcher::instance(); // ensure at least one watcher exists
 
@@ -120,7 +129,9 @@ void StatusNotifierHost::connectToWatcher() {
 
 QList<StatusNotifierItem*> StatusNotifierHost::items() const {
 	auto items = this->mItems.values();
-	items.removeIf([](StatusNotifierItem* item) { return !item->isReady(); });
+	items.removeIf([this](StatusNotifierItem* item) {
+		return !item->isReady() || this->readyBatcher.isBatched(item);
+	});
 	return items;
 }
 
@@ -133,6 +144,10 @@ void StatusNotifierHost::onWatcherRegistered() { this->connectToWatcher(); }
 void StatusNotifierHost::onWatcherUnregistered() {
 	qCDebug(logStatusNotifierHost) << "Unregistering StatusNotifierItems from old watcher";
 
+	this->queuedItems.clear();
+	this->requestingItems.clear();
+	this->readyBatcher.clear();
+
 	for (auto [service, item]: this->mItems.asKeyValueRange()) {
 		emit this->itemUnregistered(item);
 		delete item;
@@ -162,11 +177,16 @@ void StatusNotifierHost::onItemRegistered(const QString& item) {
 	this->mItems.insert(item, dItem);
 	QObject::connect(dItem, &StatusNotifierItem::ready, this, &StatusNotifierHost::onItemReady);
 	emit this->itemRegistered(dItem);
+
+	this->readyBatcher.addLoading(dItem);
+	this->queuedItems.append(dItem);
+	this->requestQueuedItems();
 }
 
 void StatusNotifierHost::onItemUnregistered(const QString& item) {
 	if (auto* dItem = this->mItems.value(item)) {
 		this->mItems.remove(item);
+		this->forgetItem(dItem);
 		emit this->itemUnregistered(dItem);
 		delete dItem;
 		qCDebug(logStatusNotifierHost).noquote()
@@ -177,12 +197,37 @@ void StatusNotifierHost::onItemUnregistered(const QString& item) {
 	}
 }
 
-void StatusNotifierHost::onItemReady() {
-	if (auto* item = qobject_cast<StatusNotifierItem*>(this->sender())) {
-		emit this->itemReady(item);
+void StatusNotifierHost::requestQueuedItems() {
+	while (!this->queuedItems.isEmpty() && this->requestingItems.size() < MAX_REQUESTING_ITEMS) {
+		auto* item = this->queuedItems.takeFirst();
+		this->requestingItems.insert(item);
+		item->requestProperties();
+	}
+}
+
+void StatusNotifierHost::forgetItem(StatusNotifierItem* item) {
+	this->queuedItems.removeOne(item);
+	this->readyBatcher.remove(item);
+
+	if (this->requestingItems.remove(item)) {
+		this->requestQueuedItems();
 	}
 }
 
+void StatusNotifierHost::onItemReady() {
+	auto* item = qobject_cast<StatusNotifierItem*>(this->sender());
+	if (item == nullptr) return;
+
+	this->requestingItems.remove(item);
+	this->requestQueuedItems();
+	this->readyBatcher.setReady(item);
+}
+
+void StatusNotifierHost::publishReadyItems(const QVector<StatusNotifierItem*>& items) {
+	qCDebug(logStatusNotifierHost) << "Reporting" << items.length() << "ready StatusNotifierItems";
+	emit this->itemsReady(items);
+}
+
 StatusNotifierHost* StatusNotifierHost::instance() {
 	static StatusNotifierHost* instance = nullptr; // NOLINT
 	if (instance == nullptr) instance = new StatusNotifierHost();
@@ -6,8 +6,10 @@
 #include <qlist.h>
 #include <qloggingcategory.h>
 #include <qobject.h>
+#include <qset.h>
 #include <qtmetamacros.h>
 
+#include "../../core/model.hpp"
 #include "dbus_watcher_interface.h"
 #include "item.hpp"
 
@@ -29,7 +31,8 @@ public:
 
 signals:
 	void itemRegistered(StatusNotifierItem* item);
-	void itemReady(StatusNotifierItem* item);
+	// Items that became ready close together are reported in a single batch.
+	void itemsReady(const QList<StatusNotifierItem*>& items);
 	void itemUnregistered(StatusNotifierItem* item);
 
 private slots:
@@ -40,10 +43,20 @@ private slots:
 	void onItemReady();
 
 private:
+	void requestQueuedItems();
+	void publishReadyItems(const QVector<StatusNotifierItem*>& items);
+	void forgetItem(StatusNotifierItem* item);
+
 	QString hostId;
 	QDBusServiceWatcher serviceWatcher;
 	DBusStatusNotifierWatcher* watcher = nullptr;
 	QHash<QString, StatusNotifierItem*> mItems;
+
+	// items waiting for a free request slot
+	QList<StatusNotifierItem*> queuedItems;
+	// items with an in flight property request
+	QSet<StatusNotifierItem*> requestingItems;
+	ReadyBatcher<StatusNotifierItem> readyBatcher {this, &StatusNotifierHost::publishReadyItems};
 };
 
 } // namespace qs::service::sni
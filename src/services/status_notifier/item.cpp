@@ -5,6 +5,8 @@
 #include <qdbusmetatype.h>
 #include <qdbuspendingcall.h>
 #include <qdbuspendingreply.h>
+#include <qhash.h>
+#include <qhashfunctions.h>
 #include <qicon.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
@@ -35,6 +37,28 @@ Q_LOGGING_CATEGORY(logSniMenu, "quickshell.service.sni.item.menu", QtWarningMsg)
 
 namespace qs::service::sni {
 
+namespace {
+
+// Rendered pixmaps kept per item. Covers a few sizes of an icon, or the frames of a
+// short animation at one size.
+constexpr qsizetype MAX_CACHED_PIXMAPS = 16;
+
+size_t hashPixmaps(const DBusSniIconPixmapList& pixmaps, size_t seed) {
+	seed = qHash(pixmaps.size(), seed);
+
+	for (const auto& pixmap: pixmaps) {
+		seed = qHashMulti(seed, pixmap.width, pixmap.height, pixmap.data);
+	}
+
+	return seed;
+}
+
+} // namespace
+
+size_t qHash(const TrayPixmapCacheKey& key, size_t seed) {
+	return qHashMulti(seed, key.iconHash, key.size.width(), key.size.height());
+}
+
 StatusNotifierItem::StatusNotifierItem(const QString& address, QObject* parent)
     : QObject(parent)
     , watcherId(address) {
@@ -67,13 +91,17 @@ StatusNotifierItem::StatusNotifierItem(const QString& address, QObject* parent)
 	QObject::connect(this->item, &DBusStatusNotifierItem::NewAttentionIcon, &this->iconThemePath, &AbstractDBusProperty::update);
 	QObject::connect(this->item, &DBusStatusNotifierItem::NewToolTip, &this->tooltip, &AbstractDBusProperty::update);
 
-	QObject::connect(&this->iconThemePath, &AbstractDBusProperty::changed, this, &StatusNotifierItem::updateIcon);
-	QObject::connect(&this->iconName, &AbstractDBusProperty::changed, this, &StatusNotifierItem::updateIcon);
-	QObject::connect(&this->attentionIconName, &AbstractDBusProperty::changed, this, &StatusNotifierItem::updateIcon);
-	QObject::connect(&this->overlayIconName, &AbstractDBusProperty::changed, this, &StatusNotifierItem::updateIcon);
-	QObject::connect(&this->iconPixmaps, &AbstractDBusProperty::changed, this, &StatusNotifierItem::updateIcon);
-	QObject::connect(&this->attentionIconPixmaps, &AbstractDBusProperty::changed, this, &StatusNotifierItem::updateIcon);
-	QObject::connect(&this->overlayIconPixmaps, &AbstractDBusProperty::changed, this, &StatusNotifierItem::updateIcon);
+	QObject::connect(&this->iconThemePath, &AbstractDBusProperty::changed, this, &StatusNotifierItem::markIconDirty);
+	QObject::connect(&this->iconName, &AbstractDBusProperty::changed, this, &StatusNotifierItem::markIconDirty);
+	QObject::connect(&this->attentionIconName, &AbstractDBusProperty::changed, this, &StatusNotifierItem::markIconDirty);
+	QObject::connect(&this->overlayIconName, &AbstractDBusProperty::changed, this, &StatusNotifierItem::markIconDirty);
+	QObject::connect(&this->iconPixmaps, &AbstractDBusProperty::changed, this, &StatusNotifierItem::markIconDirty);
+	QObject::connect(&this->attentionIconPixmaps, &AbstractDBusProperty::changed, this, &StatusNotifierItem::markIconDirty);
+	QObject::connect(&this->overlayIconPixmaps, &AbstractDBusProperty::changed, this, &StatusNotifierItem::markIconDirty);
+	QObject::connect(&this->status, &AbstractDBusProperty::changed, this, &StatusNotifierItem::markIconDirty);
+
+	// icon properties usually change together, so the icon is only refreshed once per update batch
+	QObject::connect(&this->properties, &DBusPropertyGroup::propertiesUpdated, this, &StatusNotifierItem::updateIcon);
 
 	QObject::connect(&this->properties, &DBusPropertyGroup::getAllFinished, this, &StatusNotifierItem::onGetAllFinished);
 	QObject::connect(&this->menuPath, &AbstractDBusProperty::changed, this, &StatusNotifierItem::onMenuPathChanged);
@@ -82,15 +110,17 @@ StatusNotifierItem::StatusNotifierItem(const QString& address, QObject* parent)
 	QObject::connect(this->item, &DBusStatusNotifierItem::NewStatus, this, [this](QString value) {
 		qCDebug(logStatusNotifierItem) << "Received update for" << this->status.toString() << value;
 		this->status.set(std::move(value));
+		this->updateIcon();
 	});
 
 	this->properties.setInterface(this->item);
-	this->properties.updateAllViaGetAll();
 }
 
 bool StatusNotifierItem::isValid() const { return this->item->isValid(); }
 bool StatusNotifierItem::isReady() const { return this->mReady; }
 
+void StatusNotifierItem::requestProperties() { this->properties.updateAllViaGetAll(); }
+
 QString StatusNotifierItem::iconId() const {
 	if (this->status.get() == "NeedsAttention") {
 		auto name = this->attentionIconName.get();
@@ -102,10 +132,25 @@ QString StatusNotifierItem::iconId() const {
 			return IconImageProvider::requestString(name, this->iconThemePath.get());
 	}
 
-	return this->imageHandle.url() + "/" + QString::number(this->iconIndex);
+	return this->imageHandle.url() + "/" + QString::number(static_cast<quint64>(this->iconHash), 16);
 }
 
 QPixmap StatusNotifierItem::createPixmap(const QSize& size) const {
+	auto key = TrayPixmapCacheKey {.iconHash = this->iconHash, .size = size};
+
+	if (auto cached = this->pixmapCache.constFind(key); cached != this->pixmapCache.constEnd()) {
+		return *cached;
+	}
+
+	auto pixmap = this->renderPixmap(size);
+
+	if (this->pixmapCache.size() >= MAX_CACHED_PIXMAPS) this->pixmapCache.clear();
+	this->pixmapCache.insert(key, pixmap);
+
+	return pixmap;
+}
+
+QPixmap StatusNotifierItem::renderPixmap(const QSize& size) const {
 	auto needsAttention = this->status.get() == "NeedsAttention";
 
 	auto closestPixmap = [](const QSize& size, const DBusSniIconPixmapList& pixmaps) {
@@ -227,11 +272,34 @@ void StatusNotifierItem::scroll(qint32 delta, bool horizontal) {
 	this->item->Scroll(delta, horizontal ? "horizontal" : "vertical");
 }
 
+void StatusNotifierItem::markIconDirty() { this->iconDirty = true; }
+
 void StatusNotifierItem::updateIcon() {
-	this->iconIndex++;
+	if (!this->iconDirty) return;
+	this->iconDirty = false;
+
+	auto hash = this->computeIconHash();
+	if (hash == this->iconHash) return;
+
+	this->iconHash = hash;
 	emit this->iconChanged();
 }
 
+size_t StatusNotifierItem::computeIconHash() const {
+	auto seed = qHashMulti(
+	    0,
+	    this->status.get() == "NeedsAttention",
+	    this->iconThemePath.get(),
+	    this->iconName.get(),
+	    this->overlayIconName.get(),
+	    this->attentionIconName.get()
+	);
+
+	seed = hashPixmaps(this->iconPixmaps.get(), seed);
+	seed = hashPixmaps(this->overlayIconPixmaps.get(), seed);
+	return hashPixmaps(this->attentionIconPixmaps.get(), seed);
+}
+
 DBusMenuHandle* StatusNotifierItem::menuHandle() {
 	return this->menuPath.get().path().isEmpty() ? nullptr : &this->mMenuHandle;
 }
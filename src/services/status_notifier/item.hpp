@@ -2,10 +2,12 @@
 
 #include <qdbusextratypes.h>
 #include <qdbuspendingcall.h>
+#include <qhash.h>
 #include <qicon.h>
 #include <qloggingcategory.h>
 #include <qobject.h>
 #include <qpixmap.h>
+#include <qsize.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 
@@ -21,6 +23,15 @@ namespace qs::service::sni {
 
 class StatusNotifierItem;
 
+struct TrayPixmapCacheKey {
+	size_t iconHash = 0;
+	QSize size;
+
+	[[nodiscard]] bool operator==(const TrayPixmapCacheKey& other) const = default;
+};
+
+size_t qHash(const TrayPixmapCacheKey& key, size_t seed = 0);
+
 class TrayImageHandle: public QsImageHandle {
 public:
 	explicit TrayImageHandle(StatusNotifierItem* item);
@@ -39,6 +50,9 @@ public:
 
 	[[nodiscard]] bool isValid() const;
 	[[nodiscard]] bool isReady() const;
+
+	// Requests the initial property set. The item becomes ready once it has been received.
+	void requestProperties();
 	[[nodiscard]] QString iconId() const;
 	[[nodiscard]] QPixmap createPixmap(const QSize& size) const;
 
@@ -73,12 +87,15 @@ signals:
 	void ready();
 
 private slots:
+	void markIconDirty();
 	void updateIcon();
 	void onGetAllFinished();
 	void onMenuPathChanged();
 
 private:
 	void updateMenuState();
+	[[nodiscard]] size_t computeIconHash() const;
+	[[nodiscard]] QPixmap renderPixmap(const QSize& size) const;
 
 	DBusStatusNotifierItem* item = nullptr;
 	TrayImageHandle imageHandle {this};
@@ -86,8 +103,11 @@ private:
 
 	dbus::dbusmenu::DBusMenuHandle mMenuHandle {this};
 
-	// bumped to inhibit caching
-	quint32 iconIndex = 0;
+	// Hash of everything the icon is rendered from. Used in image urls so unchanged or
+	// previously seen icons (e.g. frames of an animation) hit the QML pixmap cache.
+	size_t iconHash = 0;
+	bool iconDirty = false;
+	mutable QHash<TrayPixmapCacheKey, QPixmap> pixmapCache;
 	QString watcherId;
 };
 
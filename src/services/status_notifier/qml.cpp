@@ -150,7 +150,7 @@ SystemTray::SystemTray(QObject* parent): QObject(parent) {
 	auto* host = StatusNotifierHost::instance();
 
 	// clang-format off
-	QObject::connect(host, &StatusNotifierHost::itemReady, this, &SystemTray::onItemRegistered);
+	QObject::connect(host, &StatusNotifierHost::itemsReady, this, &SystemTray::onItemsReady);
 	QObject::connect(host, &StatusNotifierHost::itemUnregistered, this, &SystemTray::onItemUnregistered);
 	// clang-format on
 
@@ -159,8 +159,15 @@ SystemTray::SystemTray(QObject* parent): QObject(parent) {
 	}
 }
 
-void SystemTray::onItemRegistered(StatusNotifierItem* item) {
-	this->mItems.insertObject(new SystemTrayItem(item, this));
+void SystemTray::onItemsReady(const QList<StatusNotifierItem*>& items) {
+	auto trayItems = QVector<SystemTrayItem*>();
+	trayItems.reserve(items.length());
+
+	for (auto* item: items) {
+		trayItems.append(new SystemTrayItem(item, this));
+	}
+
+	this->mItems.insertObjects(trayItems);
 }
 
 void SystemTray::onItemUnregistered(StatusNotifierItem* item) {
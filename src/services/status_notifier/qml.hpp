@@ -1,5 +1,6 @@
 #pragma once
 
+#include <qcontainerfwd.h>
 #include <qobject.h>
 #include <qqmlintegration.h>
 #include <qtclasshelpermacros.h>
@@ -135,7 +136,7 @@ public:
 	[[nodiscard]] ObjectModel<SystemTrayItem>* items();
 
 private slots:
-	void onItemRegistered(qs::service::sni::StatusNotifierItem* item);
+	void onItemsReady(const QList<qs::service::sni::StatusNotifierItem*>& items);
 	void onItemUnregistered(qs::service::sni::StatusNotifierItem* item);
 
 private:
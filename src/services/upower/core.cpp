@@ -1,4 +1,5 @@
 #include "core.hpp"
+#include <algorithm>
 
 #include <qcontainerfwd.h>
 #include <qdbusconnection.h>
@@ -67,10 +68,10 @@ void UPower::init() {
 }
 
 void UPower::registerExisting() {
-	this->registerDevice("/org/freedesktop/UPower/devices/DisplayDevice");
-
+	// send the enumeration first so it is in flight alongside the display device's GetAll
 	auto pending = this->service->EnumerateDevices();
 	auto* call = new QDBusPendingCallWatcher(pending, this);
+	this->readyBatcher.setHeld(true);
 
 	auto responseCallback = [this](QDBusPendingCallWatcher* call) {
 		const QDBusPendingReply<QList<QDBusObjectPath>> reply = *call;
@@ -84,29 +85,37 @@ void UPower::registerExisting() {
 		}
 
 		delete call;
+		this->readyBatcher.setHeld(false);
 	};
 
 	QObject::connect(call, &QDBusPendingCallWatcher::finished, this, responseCallback);
+
+	this->registerDevice("/org/freedesktop/UPower/devices/DisplayDevice");
 }
 
 void UPower::onDeviceReady() {
 	auto* device = qobject_cast<UPowerDevice*>(this->sender());
+	if (device == nullptr) return;
 
 	if (device->path() == "/org/freedesktop/UPower/devices/DisplayDevice") {
+		if (device == this->mDisplayDevice) return;
 		this->mDisplayDevice = device;
 		emit this->displayDeviceChanged();
 		qCDebug(logUPower) << "Display UPowerDevice" << device->path() << "ready";
-		return;
+	} else if (this->readyBatcher.setReady(device)) {
+		qCDebug(logUPower) << "UPowerDevice" << device->path() << "ready";
 	}
+}
 
-	this->readyDevices.insertObject(device);
-	qCDebug(logUPower) << "UPowerDevice" << device->path() << "ready";
+void UPower::publishReadyDevices(const QVector<UPowerDevice*>& devices) {
+	this->readyDevices.insertObjects(devices);
 }
 
 void UPower::onDeviceDestroyed(QObject* object) {
 	auto* device = static_cast<UPowerDevice*>(object); // NOLINT
 
 	this->mDevices.remove(device->path());
+	this->readyBatcher.remove(device);
 
 	if (device == this->mDisplayDevice) {
 		this->mDisplayDevice = nullptr;
@@ -132,7 +141,13 @@ void UPower::registerDevice(const QString& path) {
 		return;
 	}
 
+	device->setThrottleInterval(this->mThrottleInterval);
 	this->mDevices.insert(path, device);
+	// the display device is published on its own, not through the devices model
+	if (path != "/org/freedesktop/UPower/devices/DisplayDevice") {
+		this->readyBatcher.addLoading(device);
+	}
+
 	QObject::connect(device, &UPowerDevice::ready, this, &UPower::onDeviceReady);
 	QObject::connect(device, &QObject::destroyed, this, &UPower::onDeviceDestroyed);
 
@@ -145,6 +160,20 @@ ObjectModel<UPowerDevice>* UPower::devices() { return &this->readyDevices; }
 
 bool UPower::onBattery() const { return this->pOnBattery.get(); }
 
+qint32 UPower::throttleInterval() const { return this->mThrottleInterval; }
+
+void UPower::setThrottleInterval(qint32 throttleInterval) {
+	throttleInterval = std::max(throttleInterval, 0);
+	if (throttleInterval == this->mThrottleInterval) return;
+	this->mThrottleInterval = throttleInterval;
+
+	for (auto* device: this->mDevices) {
+		device->setThrottleInterval(throttleInterval);
+	}
+
+	emit this->throttleIntervalChanged();
+}
+
 UPower* UPower::instance() {
 	static UPower* instance = new UPower(); // NOLINT
 	return instance;
@@ -163,6 +192,16 @@ UPowerQml::UPowerQml(QObject* parent): QObject(parent) {
 	    this,
 	    &UPowerQml::onBatteryChanged
 	);
+	QObject::connect(
+	    UPower::instance(),
+	    &UPower::throttleIntervalChanged,
+	    this,
+	    &UPowerQml::throttleIntervalChanged
+	);
+
+	// The singleton is recreated for every generation, while the service is shared between them.
+	// Reset the throttle so a config that no longer sets it does not keep the previous one.
+	UPower::instance()->setThrottleInterval(0);
 }
 
 UPowerDevice* UPowerQml::displayDevice() { // NOLINT
@@ -175,4 +214,10 @@ ObjectModel<UPowerDevice>* UPowerQml::devices() { // NOLINT
 
 bool UPowerQml::onBattery() { return UPower::instance()->onBattery(); }
 
+qint32 UPowerQml::throttleInterval() { return UPower::instance()->throttleInterval(); }
+
+void UPowerQml::setThrottleInterval(qint32 throttleInterval) {
+	UPower::instance()->setThrottleInterval(throttleInterval);
+}
+
 } // namespace qs::service::upower
@@ -2,6 +2,7 @@
 
 #include <qdbusservicewatcher.h>
 #include <qhash.h>
+#include <qlist.h>
 #include <qobject.h>
 #include <qqmlintegration.h>
 #include <qqmllist.h>
@@ -22,11 +23,15 @@ public:
 	[[nodiscard]] ObjectModel<UPowerDevice>* devices();
 	[[nodiscard]] bool onBattery() const;
 
+	[[nodiscard]] qint32 throttleInterval() const;
+	void setThrottleInterval(qint32 throttleInterval);
+
 	static UPower* instance();
 
 signals:
 	void displayDeviceChanged();
 	void onBatteryChanged();
+	void throttleIntervalChanged();
 
 private slots:
 	void onDeviceReady();
@@ -38,10 +43,13 @@ private:
 	void init();
 	void registerExisting();
 	void registerDevice(const QString& path);
+	void publishReadyDevices(const QVector<UPowerDevice*>& devices);
 
 	UPowerDevice* mDisplayDevice = nullptr;
 	QHash<QString, UPowerDevice*> mDevices;
 	ObjectModel<UPowerDevice> readyDevices {this};
+	ReadyBatcher<UPowerDevice> readyBatcher {this, &UPower::publishReadyDevices};
+	qint32 mThrottleInterval = 0;
 
 	dbus::DBusPropertyGroup serviceProperties;
 	dbus::DBusProperty<bool> pOnBattery {this->serviceProperties, "OnBattery"};
@@ -53,6 +61,7 @@ class UPowerQml: public QObject {
 	Q_OBJECT;
 	QML_NAMED_ELEMENT(UPower);
 	QML_SINGLETON;
+	// clang-format off
 	/// UPower's DisplayDevice for your system. Can be `null`.
 	///
 	/// This is an aggregate device and not a physical one, meaning you will not find it in @@devices.
@@ -62,6 +71,15 @@ class UPowerQml: public QObject {
 	Q_PROPERTY(ObjectModel<UPowerDevice>* devices READ devices CONSTANT);
 	/// If the system is currently running on battery power, or discharging.
 	Q_PROPERTY(bool onBattery READ onBattery NOTIFY onBatteryChanged);
+	/// The minimum time in milliseconds between updates of rapidly changing device properties.
+	/// Defaults to 0, which updates them as often as UPower reports changes.
+	///
+	/// Affects @@UPowerDevice.energy, @@UPowerDevice.changeRate, @@UPowerDevice.timeToEmpty
+	/// and @@UPowerDevice.timeToFull of every device. The first change after a quiet period is
+	/// reported immediately, and changes to @@UPowerDevice.state, @@UPowerDevice.isPresent and
+	/// @@UPowerDevice.powerSupply always report the current values of these properties.
+	Q_PROPERTY(qint32 throttleInterval READ throttleInterval WRITE setThrottleInterval NOTIFY throttleIntervalChanged);
+	// clang-format on
 
 public:
 	explicit UPowerQml(QObject* parent = nullptr);
@@ -70,9 +88,13 @@ public:
 	[[nodiscard]] ObjectModel<UPowerDevice>* devices();
 	[[nodiscard]] static bool onBattery();
 
+	[[nodiscard]] static qint32 throttleInterval();
+	static void setThrottleInterval(qint32 throttleInterval);
+
 signals:
 	void displayDeviceChanged();
 	void onBatteryChanged();
+	void throttleIntervalChanged();
 };
 
 } // namespace qs::service::upower
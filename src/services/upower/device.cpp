@@ -6,6 +6,7 @@
 #include <qloggingcategory.h>
 #include <qobject.h>
 #include <qstring.h>
+#include <qtimer.h>
 #include <qtypes.h>
 
 #include "../../dbus/properties.hpp"
@@ -77,11 +78,11 @@ UPowerDevice::UPowerDevice(const QString& path, QObject* parent): QObject(parent
 	// clang-format off
 	QObject::connect(&this->pType, &AbstractDBusProperty::changed, this, &UPowerDevice::typeChanged);
 	QObject::connect(&this->pPowerSupply, &AbstractDBusProperty::changed, this, &UPowerDevice::powerSupplyChanged);
-	QObject::connect(&this->pEnergy, &AbstractDBusProperty::changed, this, &UPowerDevice::energyChanged);
+	QObject::connect(&this->pEnergy, &AbstractDBusProperty::changed, this, [this]() { this->onThrottledChanged(ThrottledEnergy); });
 	QObject::connect(&this->pEnergyCapacity, &AbstractDBusProperty::changed, this, &UPowerDevice::energyCapacityChanged);
-	QObject::connect(&this->pChangeRate, &AbstractDBusProperty::changed, this, &UPowerDevice::changeRateChanged);
-	QObject::connect(&this->pTimeToEmpty, &AbstractDBusProperty::changed, this, &UPowerDevice::timeToEmptyChanged);
-	QObject::connect(&this->pTimeToFull, &AbstractDBusProperty::changed, this, &UPowerDevice::timeToFullChanged);
+	QObject::connect(&this->pChangeRate, &AbstractDBusProperty::changed, this, [this]() { this->onThrottledChanged(ThrottledChangeRate); });
+	QObject::connect(&this->pTimeToEmpty, &AbstractDBusProperty::changed, this, [this]() { this->onThrottledChanged(ThrottledTimeToEmpty); });
+	QObject::connect(&this->pTimeToFull, &AbstractDBusProperty::changed, this, [this]() { this->onThrottledChanged(ThrottledTimeToFull); });
 	QObject::connect(&this->pPercentage, &AbstractDBusProperty::changed, this, &UPowerDevice::percentageChanged);
 	QObject::connect(&this->pIsPresent, &AbstractDBusProperty::changed, this, &UPowerDevice::isPresentChanged);
 	QObject::connect(&this->pState, &AbstractDBusProperty::changed, this, &UPowerDevice::stateChanged);
@@ -91,9 +92,17 @@ UPowerDevice::UPowerDevice(const QString& path, QObject* parent): QObject(parent
 	QObject::connect(&this->pType, &AbstractDBusProperty::changed, this, &UPowerDevice::isLaptopBatteryChanged);
 	QObject::connect(&this->pNativePath, &AbstractDBusProperty::changed, this, &UPowerDevice::nativePathChanged);
 
+	// state transitions are never delayed, and bring throttled properties up to date with them
+	QObject::connect(&this->pState, &AbstractDBusProperty::changed, this, &UPowerDevice::flushThrottled);
+	QObject::connect(&this->pPowerSupply, &AbstractDBusProperty::changed, this, &UPowerDevice::flushThrottled);
+	QObject::connect(&this->pIsPresent, &AbstractDBusProperty::changed, this, &UPowerDevice::flushThrottled);
+	QObject::connect(&this->throttleTimer, &QTimer::timeout, this, &UPowerDevice::onThrottleTimeout);
+
 	QObject::connect(&this->deviceProperties, &DBusPropertyGroup::getAllFinished, this, &UPowerDevice::ready);
 	// clang-format on
 
+	this->throttleTimer.setSingleShot(true);
+
 	this->deviceProperties.setInterface(this->device);
 	this->deviceProperties.updateAllViaGetAll();
 }
@@ -131,4 +140,40 @@ bool UPowerDevice::isLaptopBattery() const {
 
 QString UPowerDevice::nativePath() const { return this->pNativePath.get(); }
 
+void UPowerDevice::setThrottleInterval(qint32 throttleInterval) {
+	this->throttleInterval = throttleInterval;
+
+	if (throttleInterval <= 0) {
+		this->throttleTimer.stop();
+		this->flushThrottled();
+	}
+}
+
+void UPowerDevice::onThrottledChanged(ThrottledProperty property) {
+	this->pendingThrottled |= property;
+
+	// the first change in a while is sent immediately, and later ones wait for the interval
+	if (this->throttleTimer.isActive()) return;
+
+	this->flushThrottled();
+	if (this->throttleInterval > 0) this->throttleTimer.start(this->throttleInterval);
+}
+
+void UPowerDevice::onThrottleTimeout() {
+	if (this->pendingThrottled == 0) return;
+
+	this->flushThrottled();
+	this->throttleTimer.start(this->throttleInterval);
+}
+
+void UPowerDevice::flushThrottled() {
+	auto pending = this->pendingThrottled;
+	this->pendingThrottled = 0;
+
+	if (pending & ThrottledEnergy) emit this->energyChanged();
+	if (pending & ThrottledChangeRate) emit this->changeRateChanged();
+	if (pending & ThrottledTimeToEmpty) emit this->timeToEmptyChanged();
+	if (pending & ThrottledTimeToFull) emit this->timeToFullChanged();
+}
+
 } // namespace qs::service::upower
@@ -3,6 +3,7 @@
 #include <qcontainerfwd.h>
 #include <qobject.h>
 #include <qqmlintegration.h>
+#include <qtimer.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 
@@ -150,6 +151,10 @@ public:
 	[[nodiscard]] bool isLaptopBattery() const;
 	[[nodiscard]] QString nativePath() const;
 
+	// Minimum time between change signals of rapidly changing numeric properties.
+	// 0 disables throttling.
+	void setThrottleInterval(qint32 throttleInterval);
+
 signals:
 	QSDOC_HIDE void ready();
 
@@ -169,7 +174,24 @@ signals:
 	void isLaptopBatteryChanged();
 	void nativePathChanged();
 
+private slots:
+	void flushThrottled();
+	void onThrottleTimeout();
+
 private:
+	enum ThrottledProperty : quint8 {
+		ThrottledEnergy = 0b1,
+		ThrottledChangeRate = 0b10,
+		ThrottledTimeToEmpty = 0b100,
+		ThrottledTimeToFull = 0b1000,
+	};
+
+	void onThrottledChanged(ThrottledProperty property);
+
+	qint32 throttleInterval = 0;
+	QTimer throttleTimer;
+	quint8 pendingThrottled = 0;
+
 	dbus::DBusPropertyGroup deviceProperties;
 	dbus::DBusProperty<quint32> pType {this->deviceProperties, "Type"};
 	dbus::DBusProperty<bool> pPowerSupply {this->deviceProperties, "PowerSupply"};